@@ -18,18 +18,62 @@ IncludeDir = {}
 IncludeDir["nlohmann"] = "vendor/nlohmann/include"
 IncludeDir["fifo_map"] = "vendor/fifo_map/src"
 
-project "ivam"
-kind "ConsoleApp"
-language "C++"
-cppdialect "C++20"
-staticruntime "on"
-
-targetdir("bin/" .. outputdir .. "/%{prj.name}")
-objdir("src/obj/" .. outputdir .. "/%{prj.name}")
-
-pchheader "pch.h"
-pchsource "src/pch.cpp"
-
+-- Settings shared by every executable, each project only adds its files
+function ConsoleProject(name)
+    project(name)
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "on"
+
+    targetdir("bin/" .. outputdir .. "/%{prj.name}")
+    objdir("src/obj/" .. outputdir .. "/%{prj.name}")
+
+    pchheader "pch.h"
+    pchsource "src/pch.cpp"
+
+    includedirs
+    {
+        "src",
+        "%{IncludeDir.nlohmann}",
+        "%{IncludeDir.fifo_map}"
+    }
+
+    defines { "_CRT_SECURE_NO_WARNINGS", "_SILENCE_ALL_CXX17_DEPRECATION_WARNINGS" }
+    buildoptions { 
+        "/bigobj", 
+        "/Zc:__cplusplus",
+        "/permissive-",
+        "/Zc:preprocessor"
+    }
+
+    filter "configurations:Debug"
+    defines { "DEBUG", "_DEBUG" }
+    runtime "Debug"
+    symbols "on"
+    optimize "off"
+    buildoptions { "/JMC" }
+    linkoptions { "/DEBUG:FASTLINK" }
+
+    filter "configurations:Release"
+    defines { "NDEBUG", "RELEASE" }
+    runtime "Release"
+    symbols "off"
+    optimize "speed"
+    buildoptions { 
+        "/GL",
+        "/Gy"
+    }
+    linkoptions { 
+        "/LTCG",
+        "/OPT:REF",
+        "/OPT:ICF"
+    }
+
+    filter {}
+end
+
+ConsoleProject "ivam"
 files
 {
     "src/**.h",
@@ -40,42 +84,49 @@ files
     "src/**.cpp"
 }
 
-includedirs
+-- Times each conversion stage of ivam, see tools/bench
+ConsoleProject "ivam-bench"
+files
 {
-    "src",
-    "%{IncludeDir.nlohmann}",
-    "%{IncludeDir.fifo_map}"
+    "src/pch.h",
+    "src/pch.cpp",
+    "src/common/**.h",
+    "src/common/**.cpp",
+    "tools/bench/BenchUtils.h",
+    "tools/bench/BenchUtils.cpp",
+    "tools/bench/ToolArgs.h",
+    "tools/bench/Bench.cpp"
 }
 
-defines { "_CRT_SECURE_NO_WARNINGS", "_SILENCE_ALL_CXX17_DEPRECATION_WARNINGS" }
-buildoptions { 
-    "/bigobj", 
-    "/Zc:__cplusplus",
-    "/permissive-",
-    "/Zc:preprocessor"
+-- Random metadata files of any size, see tools/corpus
+ConsoleProject "ivam-corpus"
+includedirs { "tools" }
+files
+{
+    "src/pch.h",
+    "src/pch.cpp",
+    "src/common/**.h",
+    "src/common/**.cpp",
+    "tools/bench/ToolArgs.h",
+    "tools/corpus/**.h",
+    "tools/corpus/**.cpp"
 }
 
-filter "configurations:Debug"
-defines { "DEBUG", "_DEBUG" }
-runtime "Debug"
-symbols "on"
-optimize "off"
-buildoptions { "/JMC" }
-linkoptions { "/DEBUG:FASTLINK" }
-
-filter "configurations:Release"
-defines { "NDEBUG", "RELEASE" }
-runtime "Release"
-symbols "off"
-optimize "speed"
-buildoptions { 
-    "/GL",
-    "/Gy"
-}
-linkoptions { 
-    "/LTCG",
-    "/OPT:REF",
-    "/OPT:ICF"
+-- Times the FieldIO kernels one kind of field at a time, see tools/bench
+ConsoleProject "ivam-fieldbench"
+includedirs { "tools" }
+files
+{
+    "src/pch.h",
+    "src/pch.cpp",
+    "src/common/**.h",
+    "src/common/**.cpp",
+    "tools/bench/BenchUtils.h",
+    "tools/bench/BenchUtils.cpp",
+    "tools/bench/ToolArgs.h",
+    "tools/bench/FieldBench.cpp",
+    "tools/corpus/CorpusGenerator.h",
+    "tools/corpus/CorpusGenerator.cpp"
 }
 
 -- Custom actions for dependency management
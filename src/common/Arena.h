@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace AMT
+{
+    // Bump allocator for data that lives as long as its owner, e.g. the decoded values
+    // of a file. Nothing is freed individually and no destructors are run.
+    class Arena
+    {
+        struct Block
+        {
+            std::unique_ptr<uint8_t[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> m_Blocks;
+        uint8_t* m_Ptr = nullptr;
+        size_t m_Left = 0;
+        size_t m_BlockSize;
+        size_t m_BytesUsed = 0;
+
+        uint8_t* AddBlock(size_t size)
+        {
+            m_Blocks.push_back({std::make_unique<uint8_t[]>(size), size});
+            return m_Blocks.back().data.get();
+        }
+
+    public:
+        explicit Arena(size_t blockSize = 64 * 1024) : m_BlockSize(blockSize) {}
+
+        Arena(Arena&&) = default;
+        Arena& operator=(Arena&&) = default;
+
+        void* Allocate(size_t size, size_t align = alignof(std::max_align_t))
+        {
+            m_BytesUsed += size;
+
+            size_t pad = (align - reinterpret_cast<uintptr_t>(m_Ptr) % align) % align;
+            if (pad + size > m_Left)
+            {
+                // Big allocations get a block of their own, so the current one isn't wasted
+                if (size > m_BlockSize / 4)
+                    return AddBlock(size);
+
+                m_Ptr = AddBlock(m_BlockSize);
+                m_Left = m_BlockSize;
+                pad = 0;
+            }
+
+            uint8_t* p = m_Ptr + pad;
+            m_Ptr = p + size;
+            m_Left -= pad + size;
+            return p;
+        }
+
+        // count value-initialised Ts. T must be trivially destructible.
+        template <typename T>
+        T* AllocateArray(size_t count)
+        {
+            if (count == 0)
+                return nullptr;
+
+            T* p = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+            for (size_t i = 0; i < count; i++)
+            {
+                new (p + i) T();
+            }
+            return p;
+        }
+
+        template <typename T>
+        const T* Copy(const T* data, size_t count)
+        {
+            if (count == 0)
+                return nullptr;
+
+            T* p = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+            memcpy(p, data, sizeof(T) * count);
+            return p;
+        }
+
+        // Frees everything allocated so far. One block is kept for the next allocations.
+        void Reset()
+        {
+            Block keep{};
+            for (auto& block : m_Blocks)
+            {
+                if (block.size == m_BlockSize)
+                {
+                    keep = std::move(block);
+                    break;
+                }
+            }
+
+            m_Blocks.clear();
+            m_Ptr = keep.data.get();
+            m_Left = keep.data ? m_BlockSize : 0;
+            m_BytesUsed = 0;
+            if (keep.data)
+                m_Blocks.push_back(std::move(keep));
+        }
+
+        size_t GetBytesUsed() const { return m_BytesUsed; }
+        size_t GetNumBlocks() const { return m_Blocks.size(); }
+    };
+} // namespace AMT
@@ -1,9 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <string>
-#include <vector>
-#include <utility>
+#include <string_view>
 
 namespace AMT
 {
@@ -26,30 +25,56 @@ namespace AMT
         Placeholder
     };
 
+    // Read-only view of a static table. Schemas are constexpr data, so a field refers to
+    // its children through one of these rather than owning them.
+    template <typename T>
+    struct SchemaSpan
+    {
+        const T* data = nullptr;
+        size_t count = 0;
+
+        constexpr SchemaSpan() = default;
+
+        template <size_t N>
+        constexpr SchemaSpan(const T (&items)[N]) : data(items), count(N) {}
+
+        constexpr const T* begin() const { return data; }
+        constexpr const T* end() const { return data + count; }
+        constexpr size_t size() const { return count; }
+        constexpr bool empty() const { return count == 0; }
+        constexpr const T& operator[](size_t i) const { return data[i]; }
+    };
+
+    struct EnumValue
+    {
+        int64_t value;
+        std::string_view name;
+    };
+
     struct FieldDef
     {
-        std::string name;
+        std::string_view name;
         FieldKind kind;
         bool trackedAsHash = false;
         bool trackedAsArchive = false;
         FieldKind countKind = FieldKind::UInt8;
         bool arrayElementsAreTrackedHashes = false;
-        std::vector<FieldDef> children;
+        SchemaSpan<FieldDef> children;
         int fixedCount = 0;
-        std::vector<std::pair<int64_t, std::string>> enumValues;
+        SchemaSpan<EnumValue> enumValues;
         FieldKind enumBaseKind = FieldKind::UInt8;
         int placeholderSize = 0;
     };
 
-    inline FieldDef UInt8(const std::string& name) { return {name, FieldKind::UInt8}; }
-    inline FieldDef UInt16(const std::string& name) { return {name, FieldKind::UInt16}; }
-    inline FieldDef UInt32(const std::string& name) { return {name, FieldKind::UInt32}; }
-    inline FieldDef Int8(const std::string& name) { return {name, FieldKind::Int8}; }
-    inline FieldDef Int16(const std::string& name) { return {name, FieldKind::Int16}; }
-    inline FieldDef Int32(const std::string& name) { return {name, FieldKind::Int32}; }
-    inline FieldDef Float(const std::string& name) { return {name, FieldKind::Float}; }
+    constexpr FieldDef UInt8(std::string_view name) { return {name, FieldKind::UInt8}; }
+    constexpr FieldDef UInt16(std::string_view name) { return {name, FieldKind::UInt16}; }
+    constexpr FieldDef UInt32(std::string_view name) { return {name, FieldKind::UInt32}; }
+    constexpr FieldDef Int8(std::string_view name) { return {name, FieldKind::Int8}; }
+    constexpr FieldDef Int16(std::string_view name) { return {name, FieldKind::Int16}; }
+    constexpr FieldDef Int32(std::string_view name) { return {name, FieldKind::Int32}; }
+    constexpr FieldDef Float(std::string_view name) { return {name, FieldKind::Float}; }
 
-    inline FieldDef Hash(const std::string& name, bool isHash = false, bool isArchive = false)
+    constexpr FieldDef Hash(std::string_view name, bool isHash = false, bool isArchive = false)
     {
         FieldDef f{name, FieldKind::Hash};
         f.trackedAsHash = isHash;
@@ -57,57 +82,62 @@ namespace AMT
         return f;
     }
 
-    inline FieldDef String(const std::string& name, FieldKind countKind = FieldKind::UInt8)
+    constexpr FieldDef String(std::string_view name, FieldKind countKind = FieldKind::UInt8)
     {
         FieldDef f{name, FieldKind::String};
         f.countKind = countKind;
         return f;
     }
 
-    inline FieldDef Array(const std::string& name, std::vector<FieldDef> elementFields, FieldKind countKind = FieldKind::UInt8, bool elementsAreTrackedHashes = false)
+    constexpr FieldDef Array(std::string_view name, SchemaSpan<FieldDef> elementFields, FieldKind countKind = FieldKind::UInt8, bool elementsAreTrackedHashes = false)
     {
         FieldDef f{name, FieldKind::Array};
         f.countKind = countKind;
-        f.children = std::move(elementFields);
+        f.children = elementFields;
         f.arrayElementsAreTrackedHashes = elementsAreTrackedHashes;
         return f;
     }
 
-    inline FieldDef FixedArray(const std::string& name, std::vector<FieldDef> elementFields, int count)
+    constexpr FieldDef FixedArray(std::string_view name, SchemaSpan<FieldDef> elementFields, int count)
     {
         FieldDef f{name, FieldKind::FixedArray};
-        f.children = std::move(elementFields);
+        f.children = elementFields;
         f.fixedCount = count;
         return f;
     }
 
-    inline FieldDef Struct(const std::string& name, std::vector<FieldDef> fields)
+    constexpr FieldDef Struct(std::string_view name, SchemaSpan<FieldDef> fields)
     {
         FieldDef f{name, FieldKind::Struct};
-        f.children = std::move(fields);
+        f.children = fields;
         return f;
     }
 
-    inline FieldDef OptionalBitfield(const std::string& name, std::vector<FieldDef> fields)
+    constexpr FieldDef OptionalBitfield(std::string_view name, SchemaSpan<FieldDef> fields)
     {
         FieldDef f{name, FieldKind::OptionalBitfield};
-        f.children = std::move(fields);
+        f.children = fields;
         return f;
     }
 
-    inline FieldDef Enum(const std::string& name, FieldKind baseKind, std::vector<std::pair<int64_t, std::string>> values)
+    constexpr FieldDef Enum(std::string_view name, FieldKind baseKind, SchemaSpan<EnumValue> values)
     {
         FieldDef f{name, FieldKind::Enum};
         f.enumBaseKind = baseKind;
-        f.enumValues = std::move(values);
+        f.enumValues = values;
         return f;
     }
 
-    inline FieldDef Placeholder(const std::string& name, int size = 0)
+    constexpr FieldDef Placeholder(std::string_view name, int size = 0)
     {
         FieldDef f{name, FieldKind::Placeholder};
         f.placeholderSize = size;
         return f;
     }
 
+    // Elements of arrays that hold a single unnamed value
+    inline constexpr FieldDef UInt8Elements[] = {{"", FieldKind::UInt8}};
+    inline constexpr FieldDef HashElements[] = {{"", FieldKind::Hash}};
+    inline constexpr FieldDef TrackedHashElements[] = {{"", FieldKind::Hash, true}};
+
 } // namespace AMT
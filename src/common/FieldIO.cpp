@@ -1,7 +1,6 @@
 #include "pch.h"
 #include "FieldIO.h"
-#include <sstream>
-#include <iomanip>
+#include "HexUtils.h"
 #include <cmath>
 #include <cstring>
 
@@ -14,37 +13,23 @@ namespace AMT
             return std::round(static_cast<double>(f) * 1000.0) / 1000.0;
         }
 
-        static std::string ToHex(const uint8_t* data, uint32_t size)
-        {
-            std::ostringstream ss;
-            for (uint32_t i = 0; i < size; i++)
-            {
-                if (i > 0) ss << ' ';
-                ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(data[i]);
-            }
-            return ss.str();
-        }
-
         static std::string ToHex32(const uint8_t* data, uint32_t size)
         {
-            std::ostringstream ss;
-            uint32_t i = 0;
-            while (i + 4 <= size)
-            {
-                if (i > 0) ss << ' ';
-                ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(data[i]);
-                ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(data[i+1]);
-                ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(data[i+2]);
-                ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(data[i+3]);
-                i += 4;
-            }
-            while (i < size)
+            if (size == 0)
+                return {};
+
+            // Whole words as 8 digit groups, then any leftover bytes as pairs
+            uint32_t words = size / 4;
+            uint32_t rest = size % 4;
+
+            std::string s(words * 9 + rest * 3, ' ');
+            for (uint32_t i = 0; i < words; i++)
             {
-                if (i > 0) ss << ' ';
-                ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(data[i]);
-                i++;
+                HexUtils::EncodeHex(data + i * 4, 4, s.data() + i * 9);
             }
-            return ss.str();
+            HexUtils::EncodeHexSpaced(data + words * 4, rest, s.data() + words * 9);
+            s.pop_back();
+            return s;
         }
 
         uint32_t CountPrefixSize(FieldKind kind)
@@ -61,7 +46,7 @@ namespace AMT
             }
         }
 
-        uint32_t ReadCountPrefix(uint8_t*& data, FieldKind kind)
+        uint32_t ReadCountPrefix(const uint8_t*& data, FieldKind kind)
         {
             switch (kind)
             {
@@ -73,187 +58,139 @@ namespace AMT
             }
         }
 
-        void WriteCountPrefix(std::ostream& stream, uint32_t count, FieldKind kind)
+        void WriteCountPrefix(IoUtils::MemoryWriter& out, uint32_t count, FieldKind kind)
         {
             switch (kind)
             {
-                case FieldKind::UInt8:  { uint8_t v = static_cast<uint8_t>(count); IoUtils::WriteData(stream, v); break; }
-                case FieldKind::UInt16: { uint16_t v = static_cast<uint16_t>(count); IoUtils::WriteData(stream, v); break; }
-                case FieldKind::UInt32: { IoUtils::WriteData(stream, count); break; }
-                case FieldKind::Int16:  { uint16_t v = static_cast<uint16_t>(count); IoUtils::WriteData(stream, v); break; }
-                default: { uint8_t v = static_cast<uint8_t>(count); IoUtils::WriteData(stream, v); break; }
+                case FieldKind::UInt8:  { uint8_t v = static_cast<uint8_t>(count); IoUtils::WriteData(out, v); break; }
+                case FieldKind::UInt16: { uint16_t v = static_cast<uint16_t>(count); IoUtils::WriteData(out, v); break; }
+                case FieldKind::UInt32: { IoUtils::WriteData(out, count); break; }
+                case FieldKind::Int16:  { uint16_t v = static_cast<uint16_t>(count); IoUtils::WriteData(out, v); break; }
+                default: { uint8_t v = static_cast<uint8_t>(count); IoUtils::WriteData(out, v); break; }
             }
         }
 
-        // Get the binary size of a single element described by children fields, given JSON
-        static uint32_t GetElementSize(const std::vector<FieldDef>& children, const ordered_json& elemJson)
+        // Members of the object formed by the ops [first, first + count), all absent
+        static FieldMember* NewMembers(const FieldProgram& program, uint32_t first, uint32_t count, uint32_t numSlots, Arena& arena)
         {
-            // If single child with empty name, it's a primitive element type
-            if (children.size() == 1 && children[0].name.empty())
+            FieldMember* members = arena.AllocateArray<FieldMember>(numSlots);
+            for (uint32_t i = first; i < first + count; i++)
             {
-                return GetFieldSize(children[0], elemJson);
+                const FieldOp& op = program.ops[i];
+                members[op.slot].name = &program.GetName(op);
             }
-            // Otherwise it's a struct-like element
-            uint32_t size = 0;
-            for (const auto& child : children)
+            return members;
+        }
+
+        static void SetObject(FieldValue& value, FieldMember* members, uint32_t numSlots)
+        {
+            value.type = ValueType::Object;
+            value.size = numSlots;
+            value.members = members;
+        }
+
+        static void SetObject(const FieldProgram& program, const FieldOp& op, Arena& arena, FieldValue& value)
+        {
+            SetObject(value, NewMembers(program, op.firstChild, op.numChildren, op.numSlots, arena), op.numSlots);
+        }
+
+        static void SetArray(FieldValue& value, uint32_t count, Arena& arena)
+        {
+            value.type = ValueType::Array;
+            value.size = count;
+            value.elements = arena.AllocateArray<FieldValue>(count);
+        }
+
+        // A number of any type converted to T, the way the JSON library would
+        template <typename T>
+        static T GetScalar(const FieldValue& val)
+        {
+            switch (val.type)
             {
-                if (elemJson.contains(child.name))
-                    size += GetFieldSize(child, elemJson.at(child.name));
-                else
-                    size += GetFieldSize(child, ordered_json());
+                case ValueType::UInt:  return static_cast<T>(val.u);
+                case ValueType::Int:   return static_cast<T>(val.i);
+                case ValueType::Float: return static_cast<T>(val.f);
+                case ValueType::Hash:  return static_cast<T>(val.u);
+                default:
+                    throw std::runtime_error("Field value is not a number");
             }
-            return size;
         }
 
-        uint8_t* ReadField(uint8_t* data, const FieldDef& field, ordered_json& out, ordered_json* debugJson, uint32_t remainingSize)
+        // Reads a field that has no children
+        static const uint8_t* ReadValue(const FieldProgram& program, const FieldOp& op, const uint8_t* data, Arena& arena, FieldValue& out, uint32_t remainingSize)
         {
-            uint8_t* start = data;
-            switch (field.kind)
+            switch (op.kind)
             {
                 case FieldKind::UInt8:
                 {
                     uint8_t v; memcpy(&v, data, 1); data += 1;
-                    out = v;
+                    out.type = ValueType::UInt;
+                    out.u = v;
                     break;
                 }
                 case FieldKind::UInt16:
                 {
                     uint16_t v; memcpy(&v, data, 2); data += 2;
-                    out = v;
+                    out.type = ValueType::UInt;
+                    out.u = v;
                     break;
                 }
                 case FieldKind::UInt32:
                 {
                     uint32_t v; memcpy(&v, data, 4); data += 4;
-                    out = v;
+                    out.type = ValueType::UInt;
+                    out.u = v;
                     break;
                 }
                 case FieldKind::Int8:
                 {
                     int8_t v; memcpy(&v, data, 1); data += 1;
-                    out = v;
+                    out.type = ValueType::Int;
+                    out.i = v;
                     break;
                 }
                 case FieldKind::Int16:
                 {
                     int16_t v; memcpy(&v, data, 2); data += 2;
-                    out = v;
+                    out.type = ValueType::Int;
+                    out.i = v;
                     break;
                 }
                 case FieldKind::Int32:
                 {
                     int32_t v; memcpy(&v, data, 4); data += 4;
-                    out = v;
+                    out.type = ValueType::Int;
+                    out.i = v;
                     break;
                 }
                 case FieldKind::Float:
                 {
                     float v; memcpy(&v, data, 4); data += 4;
-                    out = RoundForJson(v);
+                    out.type = ValueType::Float;
+                    out.f = v;
                     break;
                 }
                 case FieldKind::Hash:
                 {
                     uint32_t v; memcpy(&v, data, 4); data += 4;
-                    JoaatHash h(v);
-                    out = h.ToString();
+                    out.type = ValueType::Hash;
+                    out.u = v;
+                    out.str = nullptr;
                     break;
                 }
                 case FieldKind::String:
                 {
-                    uint32_t len = ReadCountPrefix(data, field.countKind);
-                    std::string s(reinterpret_cast<char*>(data), len);
+                    uint32_t len = ReadCountPrefix(data, op.countKind);
+                    out.type = ValueType::String;
+                    out.size = len;
+                    out.str = arena.Copy(reinterpret_cast<const char*>(data), len);
                     data += len;
-                    out = s;
-                    break;
-                }
-                case FieldKind::Array:
-                {
-                    uint32_t count = ReadCountPrefix(data, field.countKind);
-                    out = ordered_json::array();
-
-                    for (uint32_t i = 0; i < count; i++)
-                    {
-                        if (field.children.size() == 1 && field.children[0].name.empty())
-                        {
-                            // Primitive array element
-                            ordered_json elemVal;
-                            data = ReadField(data, field.children[0], elemVal, nullptr, 0);
-                            out.push_back(elemVal);
-                        }
-                        else
-                        {
-                            // Struct array element
-                            ordered_json elemObj;
-                            for (const auto& child : field.children)
-                            {
-                                ordered_json childVal;
-                                data = ReadField(data, child, childVal, nullptr, 0);
-                                elemObj[child.name] = childVal;
-                            }
-                            out.push_back(elemObj);
-                        }
-                    }
-                    break;
-                }
-                case FieldKind::FixedArray:
-                {
-                    out = ordered_json::array();
-                    for (int i = 0; i < field.fixedCount; i++)
-                    {
-                        if (field.children.size() == 1 && field.children[0].name.empty())
-                        {
-                            ordered_json elemVal;
-                            data = ReadField(data, field.children[0], elemVal, nullptr, 0);
-                            out.push_back(elemVal);
-                        }
-                        else
-                        {
-                            ordered_json elemObj;
-                            for (const auto& child : field.children)
-                            {
-                                ordered_json childVal;
-                                data = ReadField(data, child, childVal, nullptr, 0);
-                                elemObj[child.name] = childVal;
-                            }
-                            out.push_back(elemObj);
-                        }
-                    }
-                    break;
-                }
-                case FieldKind::Struct:
-                {
-                    ordered_json obj;
-                    for (const auto& child : field.children)
-                    {
-                        ordered_json childVal;
-                        data = ReadField(data, child, childVal, nullptr, 0);
-                        obj[child.name] = childVal;
-                    }
-                    out = obj;
-                    break;
-                }
-                case FieldKind::OptionalBitfield:
-                {
-                    uint32_t bitfield; memcpy(&bitfield, data, 4); data += 4;
-                    ordered_json obj;
-
-                    for (size_t i = 0; i < field.children.size(); i++)
-                    {
-                        if (bitfield & (1u << i))
-                        {
-                            ordered_json childVal;
-                            data = ReadField(data, field.children[i], childVal, nullptr, 0);
-                            obj[field.children[i].name] = childVal;
-                        }
-                    }
-                    out = obj;
                     break;
                 }
                 case FieldKind::Enum:
                 {
                     int64_t rawVal = 0;
-                    switch (field.enumBaseKind)
+                    switch (op.countKind)
                     {
                         case FieldKind::UInt8:  { uint8_t v; memcpy(&v, data, 1); data += 1; rawVal = v; break; }
                         case FieldKind::UInt16: { uint16_t v; memcpy(&v, data, 2); data += 2; rawVal = v; break; }
@@ -263,586 +200,1153 @@ namespace AMT
                         case FieldKind::Int32:  { int32_t v; memcpy(&v, data, 4); data += 4; rawVal = v; break; }
                         default: { uint8_t v; memcpy(&v, data, 1); data += 1; rawVal = v; break; }
                     }
-                    // Find enum string
-                    std::string enumStr;
-                    for (const auto& [val, name] : field.enumValues)
+                    // Find enum string, the value points at the static schema table
+                    const EnumValue* enumVal = program.enumTables[op.enumTable].FindValue(rawVal);
+                    if (!enumVal || enumVal->name.empty())
                     {
-                        if (val == rawVal) { enumStr = name; break; }
+                        out.type = ValueType::Int;
+                        out.i = rawVal;
                     }
-                    if (enumStr.empty())
-                        out = rawVal;
                     else
-                        out = enumStr;
+                    {
+                        out.type = ValueType::String;
+                        out.size = static_cast<uint32_t>(enumVal->name.size());
+                        out.str = enumVal->name.data();
+                    }
                     break;
                 }
                 case FieldKind::Placeholder:
                 {
-                    uint32_t sz = field.placeholderSize > 0 ? static_cast<uint32_t>(field.placeholderSize) : remainingSize;
-                    std::ostringstream ss;
-                    for (uint32_t i = 0; i < sz; i++)
-                    {
-                        if (i > 0) ss << ' ';
-                        ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(data[i]);
-                    }
-                    out = ss.str();
+                    uint32_t sz = op.count > 0 ? op.count : remainingSize;
+                    out.type = ValueType::Bytes;
+                    out.size = sz;
+                    out.bytes = arena.Copy(data, sz);
                     data += sz;
                     break;
                 }
+                default:
+                    break;
             }
-
-            if (debugJson && !field.name.empty())
-            {
-                (*debugJson)[field.name] = ToHex(start, static_cast<uint32_t>(data - start));
-            }
-
             return data;
         }
 
-        void WriteField(std::ostream& stream, const FieldDef& field, const ordered_json& val)
+        // Reads one top level field and everything below it. Containers push a frame onto a
+        // fixed stack instead of recursing, the program guarantees it is deep enough.
+        static const uint8_t* ReadOp(const FieldProgram& program, const FieldOp& root, const uint8_t* data, Arena& arena, FieldValue& out, uint32_t remainingSize)
         {
-            switch (field.kind)
+            struct Frame
             {
-                case FieldKind::UInt8:
-                {
-                    uint8_t v = val.get<uint8_t>();
-                    IoUtils::WriteData(stream, v);
-                    break;
-                }
-                case FieldKind::UInt16:
-                {
-                    uint16_t v = val.get<uint16_t>();
-                    IoUtils::WriteData(stream, v);
-                    break;
-                }
-                case FieldKind::UInt32:
-                {
-                    uint32_t v = val.get<uint32_t>();
-                    IoUtils::WriteData(stream, v);
-                    break;
-                }
-                case FieldKind::Int8:
+                const FieldOp* op;
+                FieldValue* target;
+                uint32_t next;      // next child or element
+                uint32_t end;
+                uint32_t bitfield;  // children present, if optional
+                bool optional;
+                bool elements;      // walking array elements rather than fields
+            };
+
+            Frame stack[FieldProgram::MaxDepth];
+            uint32_t depth = 0;
+
+            auto enter = [&](const FieldOp& op, FieldValue& slot, uint32_t remaining)
+            {
+                switch (op.kind)
                 {
-                    int8_t v = val.get<int8_t>();
-                    IoUtils::WriteData(stream, v);
-                    break;
+                    case FieldKind::Array:
+                    {
+                        uint32_t count = ReadCountPrefix(data, op.countKind);
+                        SetArray(slot, count, arena);
+                        stack[depth++] = {&op, &slot, 0, count, 0, false, true};
+                        break;
+                    }
+                    case FieldKind::FixedArray:
+                    {
+                        SetArray(slot, op.count, arena);
+                        stack[depth++] = {&op, &slot, 0, op.count, 0, false, true};
+                        break;
+                    }
+                    case FieldKind::Struct:
+                    {
+                        SetObject(program, op, arena, slot);
+                        stack[depth++] = {&op, &slot, 0, op.numChildren, 0, false, false};
+                        break;
+                    }
+                    case FieldKind::OptionalBitfield:
+                    {
+                        uint32_t bitfield; memcpy(&bitfield, data, 4); data += 4;
+                        SetObject(program, op, arena, slot);
+                        stack[depth++] = {&op, &slot, 0, op.numChildren, bitfield, true, false};
+                        break;
+                    }
+                    default:
+                    {
+                        data = ReadValue(program, op, data, arena, slot, remaining);
+                        break;
+                    }
                 }
-                case FieldKind::Int16:
+            };
+
+            enter(root, out, remainingSize);
+
+            while (depth > 0)
+            {
+                Frame& frame = stack[depth - 1];
+                if (frame.next == frame.end)
                 {
-                    int16_t v = val.get<int16_t>();
-                    IoUtils::WriteData(stream, v);
-                    break;
+                    depth--;
+                    continue;
                 }
-                case FieldKind::Int32:
+
+                uint32_t i = frame.next++;
+                if (frame.elements)
                 {
-                    int32_t v = val.get<int32_t>();
-                    IoUtils::WriteData(stream, v);
-                    break;
+                    FieldValue& elem = frame.target->elements[i];
+                    if (frame.op->HasFlag(FieldOpFlag_PrimitiveElement))
+                    {
+                        enter(program.ops[frame.op->firstChild], elem, 0);
+                    }
+                    else
+                    {
+                        SetObject(program, *frame.op, arena, elem);
+                        stack[depth++] = {frame.op, &elem, 0, frame.op->numChildren, 0, false, false};
+                    }
                 }
-                case FieldKind::Float:
+                else if (!frame.optional || (frame.bitfield & (1u << i)))
                 {
-                    float v = static_cast<float>(val.get<double>());
-                    IoUtils::WriteData(stream, v);
-                    break;
+                    const FieldOp& child = program.ops[frame.op->firstChild + i];
+                    enter(child, frame.target->members[child.slot].value, 0);
                 }
-                case FieldKind::Hash:
+            }
+
+            return data;
+        }
+
+        // Walks a field value (writing, measuring) without recursing. The containers are
+        // handled here and every leaf is handed to the visitor, which needs:
+        //   void Value(const FieldOp& op, const FieldValue& val)  - numbers, enums, strings, placeholders
+        //   void Hash(const FieldValue& val, bool trackedAsHash, bool trackedAsArchive)
+        //   void Count(uint32_t count, FieldKind kind)             - array count prefix
+        //   size_t BeginBitfield() / void EndBitfield(size_t token, uint32_t bitfield)
+        template <typename Visitor>
+        static void VisitOp(const FieldProgram& program, const FieldOp& root, const FieldValue& val, Visitor& visitor)
+        {
+            enum class FrameKind : uint8_t { Fields, Bitfield, Elements };
+
+            struct Frame
+            {
+                const FieldOp* op;
+                const FieldValue* val;
+                FrameKind kind;
+                uint32_t next;
+                uint32_t end;
+                uint32_t bitfield;
+                size_t token;
+            };
+
+            Frame stack[FieldProgram::MaxDepth];
+            uint32_t depth = 0;
+
+            auto enter = [&](const FieldOp& op, const FieldValue& v)
+            {
+                switch (op.kind)
                 {
-                    std::string hashStr = val.get<std::string>();
-                    JoaatHash h;
-                    h.FromJson(ordered_json(hashStr));
-                    IoUtils::WriteData(stream, h.Hash);
-                    break;
+                    case FieldKind::Hash:
+                    {
+                        visitor.Hash(v, op.HasFlag(FieldOpFlag_TrackedAsHash), op.HasFlag(FieldOpFlag_TrackedAsArchive));
+                        break;
+                    }
+                    case FieldKind::Array:
+                    {
+                        visitor.Count(v.size, op.countKind);
+                        stack[depth++] = {&op, &v, FrameKind::Elements, 0, v.size, 0, 0};
+                        break;
+                    }
+                    case FieldKind::FixedArray:
+                    {
+                        stack[depth++] = {&op, &v, FrameKind::Elements, 0, std::min<uint32_t>(op.count, v.size), 0, 0};
+                        break;
+                    }
+                    case FieldKind::Struct:
+                    {
+                        stack[depth++] = {&op, &v, FrameKind::Fields, 0, op.numChildren, 0, 0};
+                        break;
+                    }
+                    case FieldKind::OptionalBitfield:
+                    {
+                        size_t token = visitor.BeginBitfield();
+                        stack[depth++] = {&op, &v, FrameKind::Bitfield, 0, op.numChildren, 0, token};
+                        break;
+                    }
+                    default:
+                    {
+                        visitor.Value(op, v);
+                        break;
+                    }
                 }
-                case FieldKind::String:
+            };
+
+            enter(root, val);
+
+            while (depth > 0)
+            {
+                Frame& frame = stack[depth - 1];
+                if (frame.next == frame.end)
                 {
-                    std::string s = val.get<std::string>();
-                    WriteCountPrefix(stream, static_cast<uint32_t>(s.size()), field.countKind);
-                    stream.write(s.c_str(), s.size());
-                    break;
+                    if (frame.kind == FrameKind::Bitfield)
+                        visitor.EndBitfield(frame.token, frame.bitfield);
+                    depth--;
+                    continue;
                 }
-                case FieldKind::Array:
-                {
-                    uint32_t count = static_cast<uint32_t>(val.size());
-                    WriteCountPrefix(stream, count, field.countKind);
 
-                    for (uint32_t i = 0; i < count; i++)
+                uint32_t i = frame.next++;
+                switch (frame.kind)
+                {
+                    case FrameKind::Fields:
+                    {
+                        const FieldOp& child = program.ops[frame.op->firstChild + i];
+                        enter(child, frame.val->members[child.slot].value);
+                        break;
+                    }
+                    case FrameKind::Bitfield:
                     {
-                        const auto& elem = val[i];
-                        if (field.children.size() == 1 && field.children[0].name.empty())
+                        const FieldOp& child = program.ops[frame.op->firstChild + i];
+                        const FieldValue& member = frame.val->members[child.slot].value;
+                        if (member.IsPresent())
                         {
-                            WriteField(stream, field.children[0], elem);
+                            frame.bitfield |= (1u << i);
+                            enter(child, member);
                         }
+                        break;
+                    }
+                    case FrameKind::Elements:
+                    {
+                        const FieldOp& op = *frame.op;
+                        const FieldOp& first = program.ops[op.firstChild];
+                        const FieldValue& elem = frame.val->elements[i];
+
+                        if (op.HasFlag(FieldOpFlag_ElementsAreTrackedHashes))
+                            visitor.Hash(elem, true, first.HasFlag(FieldOpFlag_TrackedAsArchive));
+                        else if (op.HasFlag(FieldOpFlag_PrimitiveElement))
+                            enter(first, elem);
                         else
-                        {
-                            for (const auto& child : field.children)
-                            {
-                                WriteField(stream, child, elem.at(child.name));
-                            }
-                        }
+                            stack[depth++] = {&op, &elem, FrameKind::Fields, 0, op.numChildren, 0, 0};
+                        break;
                     }
-                    break;
                 }
-                case FieldKind::FixedArray:
+            }
+        }
+
+        // Enum text that isn't in the table, which has no value to encode
+        static std::runtime_error UnknownEnumName(const FieldProgram& program, const FieldOp& op, std::string_view name)
+        {
+            return std::runtime_error("Unknown value " + std::string(name) + " of enum " + program.GetName(op));
+        }
+
+        // Emits the binary data and, in the same walk, the patch offsets and archive names
+        class FieldWriter
+        {
+            IoUtils::MemoryWriter& m_Out;
+            const FieldProgram& m_Program;
+            FieldLayout* m_Layout;
+
+        public:
+            FieldWriter(IoUtils::MemoryWriter& out, const FieldProgram& program, FieldLayout* layout) : m_Out(out), m_Program(program), m_Layout(layout) {}
+
+            void Value(const FieldOp& op, const FieldValue& val)
+            {
+                switch (op.kind)
                 {
-                    for (int i = 0; i < field.fixedCount; i++)
+                    case FieldKind::UInt8:  { IoUtils::WriteData(m_Out, GetScalar<uint8_t>(val)); break; }
+                    case FieldKind::UInt16: { IoUtils::WriteData(m_Out, GetScalar<uint16_t>(val)); break; }
+                    case FieldKind::UInt32: { IoUtils::WriteData(m_Out, GetScalar<uint32_t>(val)); break; }
+                    case FieldKind::Int8:   { IoUtils::WriteData(m_Out, GetScalar<int8_t>(val)); break; }
+                    case FieldKind::Int16:  { IoUtils::WriteData(m_Out, GetScalar<int16_t>(val)); break; }
+                    case FieldKind::Int32:  { IoUtils::WriteData(m_Out, GetScalar<int32_t>(val)); break; }
+                    case FieldKind::Float:  { IoUtils::WriteData(m_Out, GetScalar<float>(val)); break; }
+                    case FieldKind::String:
+                    {
+                        WriteCountPrefix(m_Out, val.size, op.countKind);
+                        m_Out.Write(val.str, val.size);
+                        break;
+                    }
+                    case FieldKind::Enum:
                     {
-                        const auto& elem = val[i];
-                        if (field.children.size() == 1 && field.children[0].name.empty())
+                        int64_t rawVal = 0;
+                        if (val.type == ValueType::String)
                         {
-                            WriteField(stream, field.children[0], elem);
+                            std::string_view s(val.str, val.size);
+                            const EnumValue* ev = m_Program.enumTables[op.enumTable].FindName(s);
+                            if (!ev)
+                                throw UnknownEnumName(m_Program, op, s);
+                            rawVal = ev->value;
                         }
                         else
                         {
-                            for (const auto& child : field.children)
-                            {
-                                WriteField(stream, child, elem.at(child.name));
-                            }
+                            rawVal = GetScalar<int64_t>(val);
+                        }
+                        switch (op.countKind)
+                        {
+                            case FieldKind::UInt8:  { uint8_t v = static_cast<uint8_t>(rawVal); IoUtils::WriteData(m_Out, v); break; }
+                            case FieldKind::UInt16: { uint16_t v = static_cast<uint16_t>(rawVal); IoUtils::WriteData(m_Out, v); break; }
+                            case FieldKind::UInt32: { uint32_t v = static_cast<uint32_t>(rawVal); IoUtils::WriteData(m_Out, v); break; }
+                            case FieldKind::Int8:   { int8_t v = static_cast<int8_t>(rawVal); IoUtils::WriteData(m_Out, v); break; }
+                            case FieldKind::Int16:  { int16_t v = static_cast<int16_t>(rawVal); IoUtils::WriteData(m_Out, v); break; }
+                            case FieldKind::Int32:  { int32_t v = static_cast<int32_t>(rawVal); IoUtils::WriteData(m_Out, v); break; }
+                            default: { uint8_t v = static_cast<uint8_t>(rawVal); IoUtils::WriteData(m_Out, v); break; }
                         }
+                        break;
                     }
-                    break;
-                }
-                case FieldKind::Struct:
-                {
-                    for (const auto& child : field.children)
+                    case FieldKind::Placeholder:
                     {
-                        WriteField(stream, child, val.at(child.name));
+                        m_Out.Write(val.bytes, val.size);
+                        break;
                     }
-                    break;
+                    default:
+                        break;
                 }
-                case FieldKind::OptionalBitfield:
-                {
-                    auto bitfieldPos = stream.tellp();
-                    stream.seekp(4, std::ios_base::cur);
+            }
 
-                    uint32_t bitfield = 0;
-                    for (size_t i = 0; i < field.children.size(); i++)
-                    {
-                        if (val.contains(field.children[i].name))
-                        {
-                            WriteField(stream, field.children[i], val.at(field.children[i].name));
-                            bitfield |= (1u << i);
-                        }
-                    }
+            void Hash(const FieldValue& val, bool trackedAsHash, bool trackedAsArchive)
+            {
+                uint32_t hash = GetScalar<uint32_t>(val);
 
-                    auto endPos = stream.tellp();
-                    stream.seekp(bitfieldPos);
-                    IoUtils::WriteData(stream, bitfield);
-                    stream.seekp(endPos);
-                    break;
-                }
-                case FieldKind::Enum:
+                if (m_Layout && hash != 0xFFFFFFFF)
                 {
-                    int64_t rawVal = 0;
-                    if (val.is_string())
+                    uint32_t offset = static_cast<uint32_t>(m_Out.GetSize());
+                    if (trackedAsHash)
                     {
-                        std::string s = val.get<std::string>();
-                        for (const auto& [ev, en] : field.enumValues)
-                        {
-                            if (en == s) { rawVal = ev; break; }
-                        }
+                        m_Layout->hashOffsets.push_back(offset);
                     }
-                    else
+                    if (trackedAsArchive)
                     {
-                        rawVal = val.get<int64_t>();
-                    }
-                    switch (field.enumBaseKind)
-                    {
-                        case FieldKind::UInt8:  { uint8_t v = static_cast<uint8_t>(rawVal); IoUtils::WriteData(stream, v); break; }
-                        case FieldKind::UInt16: { uint16_t v = static_cast<uint16_t>(rawVal); IoUtils::WriteData(stream, v); break; }
-                        case FieldKind::UInt32: { uint32_t v = static_cast<uint32_t>(rawVal); IoUtils::WriteData(stream, v); break; }
-                        case FieldKind::Int8:   { int8_t v = static_cast<int8_t>(rawVal); IoUtils::WriteData(stream, v); break; }
-                        case FieldKind::Int16:  { int16_t v = static_cast<int16_t>(rawVal); IoUtils::WriteData(stream, v); break; }
-                        case FieldKind::Int32:  { int32_t v = static_cast<int32_t>(rawVal); IoUtils::WriteData(stream, v); break; }
-                        default: { uint8_t v = static_cast<uint8_t>(rawVal); IoUtils::WriteData(stream, v); break; }
+                        m_Layout->archiveOffsets.push_back(offset);
+                        // Hashes read from binary don't carry the name they were written as
+                        HashManager::HashText text;
+                        if (val.str)
+                            m_Layout->AddArchiveName(std::string_view(val.str, val.size));
+                        else
+                            m_Layout->AddArchiveName(HashManager::Instance()->HashToString(hash, text));
                     }
-                    break;
                 }
-                case FieldKind::Placeholder:
+
+                IoUtils::WriteData(m_Out, hash);
+            }
+
+            void Count(uint32_t count, FieldKind kind)
+            {
+                WriteCountPrefix(m_Out, count, kind);
+            }
+
+            size_t BeginBitfield()
+            {
+                return m_Out.Reserve(4);
+            }
+
+            void EndBitfield(size_t token, uint32_t bitfield)
+            {
+                m_Out.Patch(token, bitfield);
+            }
+        };
+
+        // Adds up the size the data would have once written
+        class FieldSizer
+        {
+        public:
+            uint32_t size = 0;
+
+            void Value(const FieldOp& op, const FieldValue& val)
+            {
+                switch (op.kind)
                 {
-                    std::string hexStr = val.get<std::string>();
-                    std::istringstream ss(hexStr);
-                    ss >> std::hex;
-                    int byte;
-                    while (ss >> byte)
-                    {
-                        uint8_t b = static_cast<uint8_t>(byte);
-                        IoUtils::WriteData(stream, b);
-                    }
-                    break;
+                    case FieldKind::UInt8:  size += 1; break;
+                    case FieldKind::UInt16: size += 2; break;
+                    case FieldKind::UInt32: size += 4; break;
+                    case FieldKind::Int8:   size += 1; break;
+                    case FieldKind::Int16:  size += 2; break;
+                    case FieldKind::Int32:  size += 4; break;
+                    case FieldKind::Float:  size += 4; break;
+                    case FieldKind::String: size += CountPrefixSize(op.countKind) + val.size; break;
+                    case FieldKind::Enum:   size += CountPrefixSize(op.countKind); break;
+                    case FieldKind::Placeholder: size += val.size; break;
+                    default:
+                        break;
                 }
             }
+
+            void Hash(const FieldValue&, bool, bool) { size += 4; }
+            void Count(uint32_t, FieldKind kind) { size += CountPrefixSize(kind); }
+            size_t BeginBitfield() { size += 4; return 0; }
+            void EndBitfield(size_t, uint32_t) {}
+        };
+
+        // Tallies the fields of each kind, for --stats
+        class FieldCounter
+        {
+        public:
+            explicit FieldCounter(uint64_t* counts) : m_Counts(counts) {}
+
+            void Value(const FieldOp& op, const FieldValue&) { Add(op.kind); }
+            void Hash(const FieldValue&, bool, bool) { Add(FieldKind::Hash); }
+            void Count(uint32_t, FieldKind) { Add(FieldKind::Array); }
+            size_t BeginBitfield() { Add(FieldKind::OptionalBitfield); return 0; }
+            void EndBitfield(size_t, uint32_t) {}
+
+        private:
+            void Add(FieldKind kind) { m_Counts[static_cast<size_t>(kind)]++; }
+
+            uint64_t* m_Counts;
+        };
+
+        // Top level fields are looked up in the object value of the whole list
+        static const FieldValue& GetRequiredField(const FieldProgram& program, const FieldOp& op, const FieldValue& val)
+        {
+            const FieldValue& field = val.members[op.slot].value;
+            if (!field.IsPresent())
+                throw std::runtime_error("Missing field " + program.GetName(op));
+            return field;
         }
 
-        uint32_t GetFieldSize(const FieldDef& field, const ordered_json& val)
+        // Every field of a fixed layout program sits at a known offset, so the record only
+        // needs the one bounds check done by the caller
+        static const uint8_t* ReadFixedFields(const uint8_t* data, const FieldProgram& program, Arena& arena, FieldValue& out, std::vector<DebugEntry>* debug)
         {
-            switch (field.kind)
+            for (uint32_t i = 0; i < program.numFields; i++)
             {
-                case FieldKind::UInt8:  return 1;
-                case FieldKind::UInt16: return 2;
-                case FieldKind::UInt32: return 4;
-                case FieldKind::Int8:   return 1;
-                case FieldKind::Int16:  return 2;
-                case FieldKind::Int32:  return 4;
-                case FieldKind::Float:  return 4;
-                case FieldKind::Hash:   return 4;
-                case FieldKind::String:
+                const FieldOp& op = program.ops[i];
+                ReadValue(program, op, data + op.offset, arena, out.members[op.slot].value, 0);
+
+                const std::string& name = program.GetName(op);
+                if (debug && !name.empty())
                 {
-                    uint32_t len = static_cast<uint32_t>(val.get<std::string>().size());
-                    return CountPrefixSize(field.countKind) + len;
+                    uint32_t end = i + 1 < program.numFields ? program.ops[i + 1].offset : program.fixedSize;
+                    debug->push_back({&name, arena.Copy(data + op.offset, end - op.offset), end - op.offset});
                 }
-                case FieldKind::Array:
+            }
+            return data + program.fixedSize;
+        }
+
+        // Batch operations on compiled field lists
+
+        const uint8_t* ReadFields(const uint8_t* data, const FieldProgram& program, Arena& arena, FieldValue& out, std::vector<DebugEntry>* debug, uint32_t remainingSize)
+        {
+            SetObject(out, NewMembers(program, 0, program.numFields, program.numSlots, arena), program.numSlots);
+
+            if (program.fixedLayout && program.fixedSize <= remainingSize)
+                return ReadFixedFields(data, program, arena, out, debug);
+
+            for (uint32_t i = 0; i < program.numFields; i++)
+            {
+                const FieldOp& op = program.ops[i];
+
+                const uint8_t* start = data;
+                data = ReadOp(program, op, data, arena, out.members[op.slot].value, remainingSize);
+
+                const std::string& name = program.GetName(op);
+                if (debug && !name.empty())
                 {
-                    uint32_t size = CountPrefixSize(field.countKind);
-                    for (const auto& elem : val)
-                    {
-                        size += GetElementSize(field.children, elem);
-                    }
-                    return size;
+                    uint32_t size = static_cast<uint32_t>(data - start);
+                    debug->push_back({&name, arena.Copy(start, size), size});
                 }
-                case FieldKind::FixedArray:
+            }
+            return data;
+        }
+
+        void WriteFields(IoUtils::MemoryWriter& out, const FieldProgram& program, const FieldValue& val, FieldLayout* layout)
+        {
+            FieldWriter writer(out, program, layout);
+
+            if (program.fixedLayout)
+            {
+                // No containers, the values go straight to the writer
+                for (uint32_t i = 0; i < program.numFields; i++)
                 {
-                    uint32_t size = 0;
-                    for (const auto& elem : val)
-                    {
-                        size += GetElementSize(field.children, elem);
-                    }
-                    return size;
+                    const FieldOp& op = program.ops[i];
+                    const FieldValue& v = GetRequiredField(program, op, val);
+                    if (op.kind == FieldKind::Hash)
+                        writer.Hash(v, op.HasFlag(FieldOpFlag_TrackedAsHash), op.HasFlag(FieldOpFlag_TrackedAsArchive));
+                    else
+                        writer.Value(op, v);
                 }
-                case FieldKind::Struct:
+                return;
+            }
+
+            for (uint32_t i = 0; i < program.numFields; i++)
+            {
+                const FieldOp& op = program.ops[i];
+                VisitOp(program, op, GetRequiredField(program, op, val), writer);
+            }
+        }
+
+        uint32_t GetFieldsSize(const FieldProgram& program, const FieldValue& val)
+        {
+            if (program.fixedLayout)
+            {
+                bool complete = true;
+                for (uint32_t i = 0; i < val.size; i++)
                 {
-                    uint32_t size = 0;
-                    for (const auto& child : field.children)
-                    {
-                        if (val.contains(child.name))
-                            size += GetFieldSize(child, val.at(child.name));
-                    }
-                    return size;
+                    complete &= val.members[i].value.IsPresent();
                 }
-                case FieldKind::OptionalBitfield:
+                if (complete)
+                    return program.fixedSize;
+            }
+
+            FieldSizer sizer;
+            for (uint32_t i = 0; i < program.numFields; i++)
+            {
+                const FieldOp& op = program.ops[i];
+                const FieldValue& field = val.members[op.slot].value;
+                if (field.IsPresent())
+                    VisitOp(program, op, field, sizer);
+            }
+            return sizer.size;
+        }
+
+        void CountFields(const FieldProgram& program, const FieldValue& val, uint64_t* counts)
+        {
+            FieldCounter counter(counts);
+            for (uint32_t i = 0; i < program.numFields; i++)
+            {
+                const FieldOp& op = program.ops[i];
+                const FieldValue& field = val.members[op.slot].value;
+                if (field.IsPresent())
+                    VisitOp(program, op, field, counter);
+            }
+        }
+
+        // JSON conversion
+
+        ordered_json ToJson(const FieldValue& val)
+        {
+            switch (val.type)
+            {
+                case ValueType::UInt:   return val.u;
+                case ValueType::Int:    return val.i;
+                case ValueType::Float:  return RoundForJson(static_cast<float>(val.f));
+                case ValueType::Hash:   return JoaatHash(static_cast<uint32_t>(val.u)).ToString();
+                case ValueType::String: return std::string(val.str, val.size);
+                case ValueType::Bytes:  return HexUtils::ToHexSpaced(val.bytes, val.size);
+                case ValueType::Array:
                 {
-                    uint32_t size = 4; // bitfield uint32
-                    for (const auto& child : field.children)
+                    ordered_json arr = ordered_json::array();
+                    for (uint32_t i = 0; i < val.size; i++)
                     {
-                        if (val.contains(child.name))
-                            size += GetFieldSize(child, val.at(child.name));
+                        arr.push_back(ToJson(val.elements[i]));
                     }
-                    return size;
-                }
-                case FieldKind::Enum:
-                {
-                    return CountPrefixSize(field.enumBaseKind);
+                    return arr;
                 }
-                case FieldKind::Placeholder:
+                case ValueType::Object:
                 {
-                    std::string hexStr = val.get<std::string>();
-                    return static_cast<uint32_t>((hexStr.size() + 1) / 3);
+                    // Stays null if no member is present
+                    ordered_json obj;
+                    AddMembersToJson(val, obj);
+                    return obj;
                 }
+                default:
+                    return nullptr;
             }
-            return 0;
         }
 
-        static void CollectElementHashOffsets(const std::vector<FieldDef>& children, const ordered_json& elemJson, std::vector<uint32_t>& offsets, uint32_t& currentOffset)
+        void AddMembersToJson(const FieldValue& val, ordered_json& j)
         {
-            if (children.size() == 1 && children[0].name.empty())
+            if (val.type != ValueType::Object)
+                return;
+
+            for (uint32_t i = 0; i < val.size; i++)
             {
-                CollectHashOffsets(children[0], elemJson, offsets, currentOffset);
-                currentOffset += GetFieldSize(children[0], elemJson);
+                const FieldMember& member = val.members[i];
+                if (member.value.IsPresent())
+                    j[*member.name] = ToJson(member.value);
             }
-            else
+        }
+
+        // A value that would come out of ToJson as null
+        static bool IsJsonNull(const FieldValue& val)
+        {
+            if (val.type == ValueType::Object)
             {
-                for (const auto& child : children)
+                for (uint32_t i = 0; i < val.size; i++)
                 {
-                    const auto& childVal = elemJson.contains(child.name) ? elemJson.at(child.name) : ordered_json();
-                    CollectHashOffsets(child, childVal, offsets, currentOffset);
-                    currentOffset += GetFieldSize(child, childVal);
+                    if (val.members[i].value.IsPresent())
+                        return false;
                 }
+                return true;
             }
+            return val.type == ValueType::Absent;
         }
 
-        void CollectHashOffsets(const FieldDef& field, const ordered_json& val, std::vector<uint32_t>& offsets, uint32_t currentOffset)
+        void WriteJson(JsonWriter& writer, const FieldValue& val)
         {
-            switch (field.kind)
+            switch (val.type)
             {
-                case FieldKind::Hash:
+                case ValueType::UInt:   writer.UInt(val.u); break;
+                case ValueType::Int:    writer.Int(val.i); break;
+                case ValueType::Float:  writer.Double(RoundForJson(static_cast<float>(val.f))); break;
+                case ValueType::Hash:
                 {
-                    if (field.trackedAsHash)
-                    {
-                        std::string hashStr = val.get<std::string>();
-                        JoaatHash h;
-                        h.FromJson(ordered_json(hashStr));
-                        if (h.Hash != 0xFFFFFFFF)
-                            offsets.push_back(currentOffset);
-                    }
+                    HashManager::HashText text;
+                    writer.String(HashManager::Instance()->HashToString(static_cast<uint32_t>(val.u), text));
                     break;
                 }
-                case FieldKind::Array:
+                case ValueType::String: writer.String(std::string_view(val.str, val.size)); break;
+                case ValueType::Bytes:  writer.String(HexUtils::ToHexSpaced(val.bytes, val.size)); break;
+                case ValueType::Array:
                 {
-                    if (field.arrayElementsAreTrackedHashes)
-                    {
-                        uint32_t off = currentOffset + CountPrefixSize(field.countKind);
-                        for (const auto& elem : val)
-                        {
-                            std::string hashStr = elem.get<std::string>();
-                            JoaatHash h;
-                            h.FromJson(ordered_json(hashStr));
-                            if (h.Hash != 0xFFFFFFFF)
-                                offsets.push_back(off);
-                            off += 4;
-                        }
-                    }
-                    else
+                    writer.BeginArray();
+                    for (uint32_t i = 0; i < val.size; i++)
                     {
-                        uint32_t off = currentOffset + CountPrefixSize(field.countKind);
-                        for (const auto& elem : val)
-                        {
-                            CollectElementHashOffsets(field.children, elem, offsets, off);
-                        }
+                        WriteJson(writer, val.elements[i]);
                     }
+                    writer.EndArray();
                     break;
                 }
-                case FieldKind::FixedArray:
+                case ValueType::Object:
                 {
-                    uint32_t off = currentOffset;
-                    for (const auto& elem : val)
+                    if (IsJsonNull(val))
                     {
-                        CollectElementHashOffsets(field.children, elem, offsets, off);
+                        writer.Null();
+                        break;
                     }
+                    writer.BeginObject();
+                    WriteMembersJson(writer, val);
+                    writer.EndObject();
                     break;
                 }
-                case FieldKind::Struct:
-                {
-                    uint32_t off = currentOffset;
-                    for (const auto& child : field.children)
-                    {
-                        const auto& childVal = val.contains(child.name) ? val.at(child.name) : ordered_json();
-                        CollectHashOffsets(child, childVal, offsets, off);
-                        off += GetFieldSize(child, childVal);
-                    }
+                default:
+                    writer.Null();
                     break;
-                }
-                case FieldKind::OptionalBitfield:
+            }
+        }
+
+        void WriteMembersJson(JsonWriter& writer, const FieldValue& val)
+        {
+            if (val.type != ValueType::Object)
+                return;
+
+            for (uint32_t i = 0; i < val.size; i++)
+            {
+                const FieldMember& member = val.members[i];
+                if (member.value.IsPresent())
                 {
-                    uint32_t off = currentOffset + 4; // skip bitfield
-                    for (const auto& child : field.children)
-                    {
-                        if (val.contains(child.name))
-                        {
-                            CollectHashOffsets(child, val.at(child.name), offsets, off);
-                            off += GetFieldSize(child, val.at(child.name));
-                        }
-                    }
-                    break;
+                    writer.Key(*member.name);
+                    WriteJson(writer, member.value);
                 }
-                default:
-                    break;
             }
         }
 
-        static void CollectElementArchiveOffsets(const std::vector<FieldDef>& children, const ordered_json& elemJson, std::vector<uint32_t>& offsets, uint32_t& currentOffset)
+        // Conversions of JSON strings, shared by the document and event based loaders
+
+        static void SetHash(const std::string& s, bool keepName, Arena& arena, FieldValue& out)
+        {
+            JoaatHash h;
+            h.FromString(s);
+            out.type = ValueType::Hash;
+            out.u = h.Hash;
+
+            // Archive names are written out under the name they were given as
+            if (keepName && h.Hash != 0xFFFFFFFF)
+            {
+                out.size = static_cast<uint32_t>(s.size());
+                out.str = arena.Copy(s.data(), s.size());
+            }
+        }
+
+        static void SetString(const std::string& s, Arena& arena, FieldValue& out)
+        {
+            out.type = ValueType::String;
+            out.size = static_cast<uint32_t>(s.size());
+            out.str = arena.Copy(s.data(), s.size());
+        }
+
+        // Names missing from the table are an error, they would silently encode as 0
+        static void SetEnum(const FieldProgram& program, const FieldOp& op, const std::string& s, FieldValue& out)
+        {
+            const EnumValue* ev = program.enumTables[op.enumTable].FindName(s);
+            if (!ev)
+                throw UnknownEnumName(program, op, s);
+            out.type = ValueType::Int;
+            out.i = ev->value;
+        }
+
+        static void SetPlaceholder(const FieldProgram& program, const FieldOp& op, const std::string& s, Arena& arena, FieldValue& out)
+        {
+            // Valid text holds at most (size + 1) / 2 bytes
+            uint8_t* bytes = static_cast<uint8_t*>(arena.Allocate((s.size() + 1) / 2, 1));
+
+            size_t size, errorPos;
+            if (!HexUtils::DecodeHexSpaced(s.data(), s.size(), bytes, size, errorPos))
+            {
+                throw std::runtime_error("Invalid hex data in " + program.GetName(op) + " at position " + std::to_string(errorPos));
+            }
+            out.type = ValueType::Bytes;
+            out.size = static_cast<uint32_t>(size);
+            out.bytes = bytes;
+        }
+
+        static void HashFromJson(const ordered_json& j, bool keepName, Arena& arena, FieldValue& out)
+        {
+            SetHash(j.get_ref<const std::string&>(), keepName, arena, out);
+        }
+
+        static void OpFromJson(const FieldProgram& program, const FieldOp& op, const ordered_json& j, Arena& arena, FieldValue& out);
+
+        static void ElementFromJson(const FieldProgram& program, const FieldOp& op, const ordered_json& elem, Arena& arena, FieldValue& out)
         {
-            if (children.size() == 1 && children[0].name.empty())
+            const FieldOp& first = program.ops[op.firstChild];
+            if (op.HasFlag(FieldOpFlag_ElementsAreTrackedHashes))
+            {
+                HashFromJson(elem, first.HasFlag(FieldOpFlag_TrackedAsArchive), arena, out);
+            }
+            else if (op.HasFlag(FieldOpFlag_PrimitiveElement))
             {
-                CollectArchiveOffsets(children[0], elemJson, offsets, currentOffset);
-                currentOffset += GetFieldSize(children[0], elemJson);
+                OpFromJson(program, first, elem, arena, out);
             }
             else
             {
-                for (const auto& child : children)
+                SetObject(program, op, arena, out);
+                for (uint32_t i = 0; i < op.numChildren; i++)
                 {
-                    const auto& childVal = elemJson.contains(child.name) ? elemJson.at(child.name) : ordered_json();
-                    CollectArchiveOffsets(child, childVal, offsets, currentOffset);
-                    currentOffset += GetFieldSize(child, childVal);
+                    const FieldOp& child = program.ops[op.firstChild + i];
+                    OpFromJson(program, child, elem.at(program.GetName(child)), arena, out.members[child.slot].value);
                 }
             }
         }
 
-        void CollectArchiveOffsets(const FieldDef& field, const ordered_json& val, std::vector<uint32_t>& offsets, uint32_t currentOffset)
+        // Values are converted to the field's type here, so writing them can't fail
+        static void OpFromJson(const FieldProgram& program, const FieldOp& op, const ordered_json& j, Arena& arena, FieldValue& out)
         {
-            switch (field.kind)
+            switch (op.kind)
             {
+                case FieldKind::UInt8:  { out.type = ValueType::UInt; out.u = j.get<uint8_t>(); break; }
+                case FieldKind::UInt16: { out.type = ValueType::UInt; out.u = j.get<uint16_t>(); break; }
+                case FieldKind::UInt32: { out.type = ValueType::UInt; out.u = j.get<uint32_t>(); break; }
+                case FieldKind::Int8:   { out.type = ValueType::Int; out.i = j.get<int8_t>(); break; }
+                case FieldKind::Int16:  { out.type = ValueType::Int; out.i = j.get<int16_t>(); break; }
+                case FieldKind::Int32:  { out.type = ValueType::Int; out.i = j.get<int32_t>(); break; }
+                case FieldKind::Float:  { out.type = ValueType::Float; out.f = static_cast<float>(j.get<double>()); break; }
                 case FieldKind::Hash:
                 {
-                    if (field.trackedAsArchive)
+                    HashFromJson(j, op.HasFlag(FieldOpFlag_TrackedAsArchive), arena, out);
+                    break;
+                }
+                case FieldKind::String:
+                {
+                    SetString(j.get_ref<const std::string&>(), arena, out);
+                    break;
+                }
+                case FieldKind::Enum:
+                {
+                    if (j.is_string())
                     {
-                        std::string hashStr = val.get<std::string>();
-                        JoaatHash h;
-                        h.FromJson(ordered_json(hashStr));
-                        if (h.Hash != 0xFFFFFFFF)
-                            offsets.push_back(currentOffset);
+                        SetEnum(program, op, j.get_ref<const std::string&>(), out);
                     }
+                    else
+                    {
+                        out.type = ValueType::Int;
+                        out.i = j.get<int64_t>();
+                    }
+                    break;
+                }
+                case FieldKind::Placeholder:
+                {
+                    SetPlaceholder(program, op, j.get_ref<const std::string&>(), arena, out);
                     break;
                 }
                 case FieldKind::Array:
                 {
-                    uint32_t off = currentOffset + CountPrefixSize(field.countKind);
-                    for (const auto& elem : val)
+                    SetArray(out, static_cast<uint32_t>(j.size()), arena);
+                    uint32_t i = 0;
+                    for (const auto& elem : j)
                     {
-                        CollectElementArchiveOffsets(field.children, elem, offsets, off);
+                        ElementFromJson(program, op, elem, arena, out.elements[i++]);
                     }
                     break;
                 }
                 case FieldKind::FixedArray:
                 {
-                    uint32_t off = currentOffset;
-                    for (const auto& elem : val)
+                    SetArray(out, op.count, arena);
+                    for (uint32_t i = 0; i < op.count; i++)
                     {
-                        CollectElementArchiveOffsets(field.children, elem, offsets, off);
+                        ElementFromJson(program, op, j.at(i), arena, out.elements[i]);
                     }
                     break;
                 }
                 case FieldKind::Struct:
                 {
-                    uint32_t off = currentOffset;
-                    for (const auto& child : field.children)
+                    SetObject(program, op, arena, out);
+                    for (uint32_t i = 0; i < op.numChildren; i++)
                     {
-                        const auto& childVal = val.contains(child.name) ? val.at(child.name) : ordered_json();
-                        CollectArchiveOffsets(child, childVal, offsets, off);
-                        off += GetFieldSize(child, childVal);
+                        const FieldOp& child = program.ops[op.firstChild + i];
+                        OpFromJson(program, child, j.at(program.GetName(child)), arena, out.members[child.slot].value);
                     }
                     break;
                 }
                 case FieldKind::OptionalBitfield:
                 {
-                    uint32_t off = currentOffset + 4;
-                    for (const auto& child : field.children)
+                    SetObject(program, op, arena, out);
+                    for (uint32_t i = 0; i < op.numChildren; i++)
                     {
-                        if (val.contains(child.name))
-                        {
-                            CollectArchiveOffsets(child, val.at(child.name), offsets, off);
-                            off += GetFieldSize(child, val.at(child.name));
-                        }
+                        const FieldOp& child = program.ops[op.firstChild + i];
+                        auto it = j.find(program.GetName(child));
+                        if (it != j.end())
+                            OpFromJson(program, child, *it, arena, out.members[child.slot].value);
                     }
                     break;
                 }
+            }
+        }
+
+        void FromJson(const FieldProgram& program, const ordered_json& j, Arena& arena, FieldValue& out)
+        {
+            SetObject(out, NewMembers(program, 0, program.numFields, program.numSlots, arena), program.numSlots);
+
+            for (uint32_t i = 0; i < program.numFields; i++)
+            {
+                const FieldOp& op = program.ops[i];
+                auto it = j.find(program.GetName(op));
+                if (it != j.end())
+                    OpFromJson(program, op, *it, arena, out.members[op.slot].value);
+            }
+        }
+        // Event based loading
+
+        // Number of any JSON type converted to a numeric field, the way get<T>() would.
+        // Returns false if the field doesn't hold a number.
+        template <typename T>
+        static bool SetNumber(const FieldOp& op, T val, FieldValue& out)
+        {
+            switch (op.kind)
+            {
+                case FieldKind::UInt8:  { out.type = ValueType::UInt; out.u = static_cast<uint8_t>(val); return true; }
+                case FieldKind::UInt16: { out.type = ValueType::UInt; out.u = static_cast<uint16_t>(val); return true; }
+                case FieldKind::UInt32: { out.type = ValueType::UInt; out.u = static_cast<uint32_t>(val); return true; }
+                case FieldKind::Int8:   { out.type = ValueType::Int; out.i = static_cast<int8_t>(val); return true; }
+                case FieldKind::Int16:  { out.type = ValueType::Int; out.i = static_cast<int16_t>(val); return true; }
+                case FieldKind::Int32:  { out.type = ValueType::Int; out.i = static_cast<int32_t>(val); return true; }
+                case FieldKind::Float:  { out.type = ValueType::Float; out.f = static_cast<float>(static_cast<double>(val)); return true; }
+                case FieldKind::Enum:   { out.type = ValueType::Int; out.i = static_cast<int64_t>(val); return true; }
                 default:
-                    break;
+                    return false;
             }
         }
 
-        void CollectArchiveNames(const FieldDef& field, const ordered_json& val, nlohmann::fifo_map<std::string, int>& names)
+        FieldBuilder::Frame& FieldBuilder::Push(FrameKind kind, const FieldProgram* program, const FieldOp* op, FieldValue* target)
+        {
+            if (m_Depth == m_Frames.size())
+                m_Frames.emplace_back();
+
+            // Frames are reused, so the element lists keep their buffers
+            Frame& frame = m_Frames[m_Depth++];
+            frame.kind = kind;
+            frame.program = program;
+            frame.op = op;
+            frame.target = target;
+            frame.pending = nullptr;
+            frame.skipNext = false;
+            frame.required = false;
+            frame.depth = 1;
+            frame.elements.clear();
+            return frame;
+        }
+
+        void FieldBuilder::InitFields(const FieldProgram& program, FieldValue& out)
         {
-            switch (field.kind)
+            SetObject(out, NewMembers(program, 0, program.numFields, program.numSlots, m_Arena), program.numSlots);
+        }
+
+        bool FieldBuilder::BeginField(const FieldProgram& program, FieldValue& fields, const std::string& key)
+        {
+            for (uint32_t i = 0; i < program.numFields; i++)
             {
-                case FieldKind::Hash:
+                const FieldOp& op = program.ops[i];
+                if (program.GetName(op) == key)
                 {
-                    if (field.trackedAsArchive)
-                    {
-                        std::string hashStr = val.get<std::string>();
-                        JoaatHash h;
-                        h.FromJson(ordered_json(hashStr));
-                        if (h.Hash != 0xFFFFFFFF)
-                            names[hashStr] = 1;
-                    }
-                    break;
+                    Push(FrameKind::Value, &program, &op, &fields.members[op.slot].value);
+                    return true;
                 }
-                case FieldKind::Array:
+            }
+            return false;
+        }
+
+        void FieldBuilder::BeginFields(const FieldProgram& program, FieldValue& out)
+        {
+            Push(FrameKind::Value, &program, nullptr, &out);
+        }
+
+        bool FieldBuilder::Next(Target& target)
+        {
+            Frame& frame = m_Frames[m_Depth - 1];
+            switch (frame.kind)
+            {
+                case FrameKind::Value:
                 {
-                    for (const auto& elem : val)
-                    {
-                        if (field.children.size() == 1 && field.children[0].name.empty())
-                            CollectArchiveNames(field.children[0], elem, names);
-                        else
-                            for (const auto& child : field.children)
-                                if (elem.contains(child.name))
-                                    CollectArchiveNames(child, elem.at(child.name), names);
-                    }
-                    break;
+                    target = {frame.program, frame.op, frame.target, false};
+                    m_Depth--;
+                    return true;
                 }
-                case FieldKind::FixedArray:
+                case FrameKind::Fields:
                 {
-                    for (const auto& elem : val)
+                    if (frame.skipNext)
                     {
-                        if (field.children.size() == 1 && field.children[0].name.empty())
-                            CollectArchiveNames(field.children[0], elem, names);
-                        else
-                            for (const auto& child : field.children)
-                                if (elem.contains(child.name))
-                                    CollectArchiveNames(child, elem.at(child.name), names);
+                        frame.skipNext = false;
+                        return false;
                     }
-                    break;
-                }
-                case FieldKind::Struct:
-                {
-                    for (const auto& child : field.children)
-                        if (val.contains(child.name))
-                            CollectArchiveNames(child, val.at(child.name), names);
-                    break;
+                    target = {frame.program, frame.pending, &frame.target->members[frame.pending->slot].value, false};
+                    frame.pending = nullptr;
+                    return true;
                 }
-                case FieldKind::OptionalBitfield:
+                case FrameKind::Elements:
                 {
-                    for (const auto& child : field.children)
-                        if (val.contains(child.name))
-                            CollectArchiveNames(child, val.at(child.name), names);
-                    break;
+                    frame.elements.emplace_back();
+                    target = {frame.program, frame.op, &frame.elements.back(), true};
+                    return true;
                 }
                 default:
-                    break;
+                    return false;
             }
         }
 
-        // Batch operations on field vectors
+        // Name of the field a value is for, for errors
+        static const std::string& GetTargetName(const FieldProgram& program, const FieldOp* op)
+        {
+            static const std::string topLevel = "fields";
+            return op ? program.GetName(*op) : topLevel;
+        }
 
-        uint8_t* ReadFields(uint8_t* data, const std::vector<FieldDef>& fields, ordered_json& out, ordered_json* debugJson, uint32_t remainingSize)
+        void FieldBuilder::Skip()
         {
-            for (const auto& field : fields)
+            Frame& frame = m_Frames[m_Depth - 1];
+            if (frame.kind == FrameKind::Skip)
+                frame.depth++;
+            else
+                Push(FrameKind::Skip, nullptr, nullptr, nullptr);
+        }
+
+        bool FieldBuilder::EndSkip()
+        {
+            Frame& frame = m_Frames[m_Depth - 1];
+            if (frame.kind != FrameKind::Skip)
+                return false;
+
+            if (--frame.depth == 0)
+                m_Depth--;
+            return true;
+        }
+
+        template <typename T>
+        void FieldBuilder::Number(T val)
+        {
+            Target t;
+            if (!Next(t))
+                return;
+
+            const FieldOp* op = t.op;
+            if (t.element)
             {
-                ordered_json fieldVal;
-                uint32_t remaining = remainingSize > 0 ? remainingSize - static_cast<uint32_t>(data - data) : 0;
-                data = ReadField(data, field, fieldVal, debugJson, remaining);
-                out[field.name] = fieldVal;
+                if (!op->HasFlag(FieldOpFlag_PrimitiveElement) || op->HasFlag(FieldOpFlag_ElementsAreTrackedHashes))
+                    throw std::runtime_error("Elements of " + t.program->GetName(*op) + " can't be numbers");
+                op = &t.program->ops[op->firstChild];
             }
-            return data;
+
+            if (!op || !SetNumber(*op, val, *t.target))
+                throw std::runtime_error("Field " + GetTargetName(*t.program, op) + " can't be a number");
         }
 
-        void WriteFields(std::ostream& stream, const std::vector<FieldDef>& fields, const ordered_json& val)
+        void FieldBuilder::Boolean(bool val) { Number<uint64_t>(val ? 1 : 0); }
+        void FieldBuilder::Integer(int64_t val) { Number(val); }
+        void FieldBuilder::Unsigned(uint64_t val) { Number(val); }
+        void FieldBuilder::Float(double val) { Number(val); }
+
+        void FieldBuilder::String(const std::string& val)
         {
-            for (const auto& field : fields)
+            Target t;
+            if (!Next(t))
+                return;
+
+            const FieldOp* op = t.op;
+            if (t.element)
             {
-                WriteField(stream, field, val.at(field.name));
+                const FieldOp& first = t.program->ops[op->firstChild];
+                if (op->HasFlag(FieldOpFlag_ElementsAreTrackedHashes))
+                {
+                    SetHash(val, first.HasFlag(FieldOpFlag_TrackedAsArchive), m_Arena, *t.target);
+                    return;
+                }
+                if (!op->HasFlag(FieldOpFlag_PrimitiveElement))
+                    throw std::runtime_error("Elements of " + t.program->GetName(*op) + " can't be strings");
+                op = &first;
+            }
+
+            switch (op ? op->kind : FieldKind::Struct)
+            {
+                case FieldKind::Hash:        SetHash(val, op->HasFlag(FieldOpFlag_TrackedAsArchive), m_Arena, *t.target); break;
+                case FieldKind::String:      SetString(val, m_Arena, *t.target); break;
+                case FieldKind::Enum:        SetEnum(*t.program, *op, val, *t.target); break;
+                case FieldKind::Placeholder: SetPlaceholder(*t.program, *op, val, m_Arena, *t.target); break;
+                default:
+                    throw std::runtime_error("Field " + GetTargetName(*t.program, op) + " can't be a string");
             }
         }
 
-        uint32_t GetFieldsSize(const std::vector<FieldDef>& fields, const ordered_json& val)
+        void FieldBuilder::Null()
         {
-            uint32_t size = 0;
-            for (const auto& field : fields)
+            Target t;
+            if (!Next(t))
+                return;
+
+            // Containers take null as empty, so the output of ToJson reads back
+            const FieldOp* op = t.op;
+            if (t.element)
+            {
+                if (op->HasFlag(FieldOpFlag_PrimitiveElement) && !op->HasFlag(FieldOpFlag_ElementsAreTrackedHashes))
+                    op = &t.program->ops[op->firstChild];
+                else if (!op->HasFlag(FieldOpFlag_ElementsAreTrackedHashes) && op->numChildren == 0)
+                {
+                    SetObject(*t.program, *op, m_Arena, *t.target);
+                    return;
+                }
+                else
+                    throw std::runtime_error("Elements of " + t.program->GetName(*op) + " can't be null");
+            }
+
+            if (!op)
             {
-                if (val.contains(field.name))
-                    size += GetFieldSize(field, val.at(field.name));
+                InitFields(*t.program, *t.target);
+                return;
+            }
+
+            switch (op->kind)
+            {
+                case FieldKind::Struct:
+                    if (op->numChildren > 0)
+                        throw std::runtime_error("Field " + t.program->GetName(*op) + " can't be null");
+                    SetObject(*t.program, *op, m_Arena, *t.target);
+                    break;
+                case FieldKind::OptionalBitfield:
+                    SetObject(*t.program, *op, m_Arena, *t.target);
+                    break;
+                case FieldKind::Array:
+                    SetArray(*t.target, 0, m_Arena);
+                    break;
+                case FieldKind::FixedArray:
+                    if (op->count > 0)
+                        throw std::runtime_error("Field " + t.program->GetName(*op) + " can't be null");
+                    SetArray(*t.target, 0, m_Arena);
+                    break;
+                default:
+                    throw std::runtime_error("Field " + t.program->GetName(*op) + " can't be null");
             }
-            return size;
         }
 
-        void CollectAllHashOffsets(const std::vector<FieldDef>& fields, const ordered_json& val, std::vector<uint32_t>& offsets, uint32_t currentOffset)
+        void FieldBuilder::StartObject()
         {
-            for (const auto& field : fields)
+            Target t;
+            if (!Next(t))
             {
-                if (val.contains(field.name))
+                Skip();
+                return;
+            }
+
+            const FieldOp* op = t.op;
+            if (!op)
+            {
+                // Top level fields, any of them may be missing
+                InitFields(*t.program, *t.target);
+                Push(FrameKind::Fields, t.program, nullptr, t.target);
+                return;
+            }
+
+            bool structElement = t.element && !op->HasFlag(FieldOpFlag_PrimitiveElement) && !op->HasFlag(FieldOpFlag_ElementsAreTrackedHashes);
+            if (t.element && !structElement)
+                throw std::runtime_error("Elements of " + t.program->GetName(*op) + " can't be objects");
+            if (!structElement && op->kind != FieldKind::Struct && op->kind != FieldKind::OptionalBitfield)
+                throw std::runtime_error("Field " + t.program->GetName(*op) + " can't be an object");
+
+            SetObject(*t.program, *op, m_Arena, *t.target);
+            Frame& frame = Push(FrameKind::Fields, t.program, op, t.target);
+            frame.required = structElement || op->kind == FieldKind::Struct;
+        }
+
+        void FieldBuilder::Key(const std::string& key)
+        {
+            if (m_Frames[m_Depth - 1].kind == FrameKind::Skip)
+                return;
+
+            Frame& frame = m_Frames[m_Depth - 1];
+            const FieldProgram& program = *frame.program;
+            uint32_t first = frame.op ? frame.op->firstChild : 0;
+            uint32_t count = frame.op ? frame.op->numChildren : program.numFields;
+
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                if (program.GetName(program.ops[i]) == key)
                 {
-                    CollectHashOffsets(field, val.at(field.name), offsets, currentOffset);
-                    currentOffset += GetFieldSize(field, val.at(field.name));
+                    frame.pending = &program.ops[i];
+                    return;
                 }
             }
+
+            // Not in the schema, the value is ignored
+            frame.skipNext = true;
         }
 
-        void CollectAllArchiveOffsets(const std::vector<FieldDef>& fields, const ordered_json& val, std::vector<uint32_t>& offsets, uint32_t currentOffset)
+        void FieldBuilder::EndObject()
         {
-            for (const auto& field : fields)
+            if (EndSkip())
+                return;
+
+            Frame& frame = m_Frames[m_Depth - 1];
+            if (frame.required)
             {
-                if (val.contains(field.name))
+                const FieldProgram& program = *frame.program;
+                for (uint32_t i = 0; i < frame.op->numChildren; i++)
                 {
-                    CollectArchiveOffsets(field, val.at(field.name), offsets, currentOffset);
-                    currentOffset += GetFieldSize(field, val.at(field.name));
+                    const FieldOp& child = program.ops[frame.op->firstChild + i];
+                    if (!frame.target->members[child.slot].value.IsPresent())
+                        throw std::runtime_error("Missing field " + program.GetName(child));
                 }
             }
+            m_Depth--;
+        }
+
+        void FieldBuilder::StartArray()
+        {
+            Target t;
+            if (!Next(t))
+            {
+                Skip();
+                return;
+            }
+
+            const FieldOp* op = t.op;
+            if (t.element)
+                op = op->HasFlag(FieldOpFlag_PrimitiveElement) && !op->HasFlag(FieldOpFlag_ElementsAreTrackedHashes) ? &t.program->ops[op->firstChild] : nullptr;
+
+            if (!op || (op->kind != FieldKind::Array && op->kind != FieldKind::FixedArray))
+                throw std::runtime_error("Field " + GetTargetName(*t.program, t.op) + " can't be an array");
+
+            Push(FrameKind::Elements, t.program, op, t.target);
         }
 
-        void CollectAllArchiveNames(const std::vector<FieldDef>& fields, const ordered_json& val, nlohmann::fifo_map<std::string, int>& names)
+        void FieldBuilder::EndArray()
         {
-            for (const auto& field : fields)
+            if (EndSkip())
+                return;
+
+            Frame& frame = m_Frames[m_Depth - 1];
+            const FieldOp& op = *frame.op;
+
+            // Fixed arrays ignore any extra elements
+            uint32_t count = static_cast<uint32_t>(frame.elements.size());
+            if (op.kind == FieldKind::FixedArray)
             {
-                if (val.contains(field.name))
-                    CollectArchiveNames(field, val.at(field.name), names);
+                if (count < op.count)
+                    throw std::runtime_error("Field " + frame.program->GetName(op) + " needs " + std::to_string(op.count) + " elements");
+                count = op.count;
             }
+
+            SetArray(*frame.target, count, m_Arena);
+            std::copy(frame.elements.begin(), frame.elements.begin() + count, frame.target->elements);
+            m_Depth--;
         }
     } // namespace FieldIO
 } // namespace AMT
@@ -1,10 +1,14 @@
 #pragma once
 
-#include "FieldDef.h"
+#include "Arena.h"
+#include "FieldProgram.h"
+#include "FieldValue.h"
 #include "HashManager.h"
 #include "IoUtils.h"
+#include "JsonWriter.h"
 #include <cstdint>
 #include <vector>
+#include <unordered_set>
 #include <fifo_map.hpp>
 #include <nlohmann/json.hpp>
 
@@ -16,50 +20,139 @@ namespace AMT
 
     namespace FieldIO
     {
-        // Read a field from binary buffer into JSON. Returns new pointer position.
-        // If debugJson is non-null, writes hex debug info there.
-        uint8_t* ReadField(uint8_t* data, const FieldDef& field, ordered_json& out, ordered_json* debugJson, uint32_t remainingSize);
-
-        // Write a field from JSON to binary stream.
-        void WriteField(std::ostream& stream, const FieldDef& field, const ordered_json& val);
-
-        // Compute the binary size of a field given its JSON value.
-        uint32_t GetFieldSize(const FieldDef& field, const ordered_json& val);
-
-        // Collect hash offsets for patching.
-        void CollectHashOffsets(const FieldDef& field, const ordered_json& val, std::vector<uint32_t>& offsets, uint32_t currentOffset);
-
-        // Collect archive offsets for patching.
-        void CollectArchiveOffsets(const FieldDef& field, const ordered_json& val, std::vector<uint32_t>& offsets, uint32_t currentOffset);
-
-        // Collect archive names.
-        void CollectArchiveNames(const FieldDef& field, const ordered_json& val, nlohmann::fifo_map<std::string, int>& names);
-
-        // Read all fields in a schema from binary. Returns new pointer.
-        uint8_t* ReadFields(uint8_t* data, const std::vector<FieldDef>& fields, ordered_json& out, ordered_json* debugJson, uint32_t remainingSize);
-
-        // Write all fields in a schema to stream.
-        void WriteFields(std::ostream& stream, const std::vector<FieldDef>& fields, const ordered_json& val);
-
-        // Get total size of all fields.
-        uint32_t GetFieldsSize(const std::vector<FieldDef>& fields, const ordered_json& val);
-
-        // Collect hash offsets for all fields.
-        void CollectAllHashOffsets(const std::vector<FieldDef>& fields, const ordered_json& val, std::vector<uint32_t>& offsets, uint32_t currentOffset);
-
-        // Collect archive offsets for all fields.
-        void CollectAllArchiveOffsets(const std::vector<FieldDef>& fields, const ordered_json& val, std::vector<uint32_t>& offsets, uint32_t currentOffset);
-
-        // Collect archive names for all fields.
-        void CollectAllArchiveNames(const std::vector<FieldDef>& fields, const ordered_json& val, nlohmann::fifo_map<std::string, int>& names);
+        // Patch offsets and archive names gathered while writing.
+        struct FieldLayout
+        {
+            std::vector<uint32_t> hashOffsets;      // positions in the output buffer
+            std::vector<uint32_t> archiveOffsets;
+            std::vector<std::string> archiveNames;  // in order of first use
+            std::unordered_set<std::string> archiveNameSet;
+
+            void AddArchiveName(std::string_view name)
+            {
+                auto [it, inserted] = archiveNameSet.emplace(name);
+                if (inserted)
+                    archiveNames.push_back(*it);
+            }
+        };
+
+        // Raw bytes of a top level field, kept for debug output
+        struct DebugEntry
+        {
+            const std::string* name;
+            const uint8_t* data;
+            uint32_t size;
+        };
+
+        // Read all fields of a compiled schema from binary into an object value allocated
+        // from arena. Returns new pointer. remainingSize is the number of bytes left in the
+        // object. If debug is non-null, the bytes of each field are recorded there.
+        const uint8_t* ReadFields(const uint8_t* data, const FieldProgram& program, Arena& arena, FieldValue& out, std::vector<DebugEntry>* debug, uint32_t remainingSize);
+
+        // Write all fields of a compiled schema to buffer. If layout is non-null, the positions of
+        // tracked hashes and archives and the archive names are collected in the same walk.
+        void WriteFields(IoUtils::MemoryWriter& out, const FieldProgram& program, const FieldValue& val, FieldLayout* layout = nullptr);
+
+        // Get total size of all fields present in val.
+        uint32_t GetFieldsSize(const FieldProgram& program, const FieldValue& val);
+
+        // Add the number of fields present in val to counts, indexed by FieldKind. Struct and
+        // FixedArray have nothing of their own in the binary and are only counted through
+        // their members.
+        void CountFields(const FieldProgram& program, const FieldValue& val, uint64_t* counts);
+
+        // Convert the JSON form of a compiled schema's fields to an object value. Fields
+        // missing from j are left absent.
+        void FromJson(const FieldProgram& program, const ordered_json& j, Arena& arena, FieldValue& out);
+
+        // JSON form of a value. Objects without any present member become null.
+        ordered_json ToJson(const FieldValue& val);
+
+        // Add the present members of an object value to j
+        void AddMembersToJson(const FieldValue& val, ordered_json& j);
+
+        // Same as ToJson and AddMembersToJson, streamed to writer
+        void WriteJson(JsonWriter& writer, const FieldValue& val);
+        void WriteMembersJson(JsonWriter& writer, const FieldValue& val);
+
+        // Builds the values of compiled schemas from JSON parser events, converting every
+        // value as it arrives, so no document is needed. Start it on a value with BeginField
+        // or BeginFields, then hand it the events while IsActive().
+        class FieldBuilder
+        {
+        public:
+            explicit FieldBuilder(Arena& arena) : m_Arena(arena) {}
+
+            // Sets out to an object value of program's fields, all absent
+            void InitFields(const FieldProgram& program, FieldValue& out);
+
+            // The next value is the field named key of fields, set up by InitFields.
+            // Returns false if program has no such field.
+            bool BeginField(const FieldProgram& program, FieldValue& fields, const std::string& key);
+
+            // The next value is an object holding the fields of program. Fields missing
+            // from it are left absent.
+            void BeginFields(const FieldProgram& program, FieldValue& out);
+
+            bool IsActive() const { return m_Depth > 0; }
+
+            void Null();
+            void Boolean(bool val);
+            void Integer(int64_t val);
+            void Unsigned(uint64_t val);
+            void Float(double val);
+            void String(const std::string& val);
+            void StartObject();
+            void Key(const std::string& key);
+            void EndObject();
+            void StartArray();
+            void EndArray();
+
+        private:
+            enum class FrameKind : uint8_t { Value, Fields, Elements, Skip };
+
+            struct Frame
+            {
+                FrameKind kind;
+                const FieldProgram* program;
+                const FieldOp* op;          // null for the top level fields of program
+                FieldValue* target;
+                const FieldOp* pending;     // Fields: the field of the next value
+                bool skipNext;              // Fields: the next value isn't in the schema
+                bool required;              // Fields: every field has to be given
+                uint32_t depth;             // Skip: containers open
+                std::vector<FieldValue> elements; // Elements: read so far
+            };
+
+            // Where the next value goes
+            struct Target
+            {
+                const FieldProgram* program;
+                const FieldOp* op;          // the array op for elements
+                FieldValue* target;
+                bool element;
+            };
+
+            Frame& Push(FrameKind kind, const FieldProgram* program, const FieldOp* op, FieldValue* target);
+            bool Next(Target& target);
+            void Skip();
+            bool EndSkip();
+
+            template <typename T>
+            void Number(T val);
+
+            Arena& m_Arena;
+            std::vector<Frame> m_Frames; // the first m_Depth are in use
+            uint32_t m_Depth = 0;
+        };
 
         // size of a count prefix
         uint32_t CountPrefixSize(FieldKind kind);
 
         // read count prefix from buffer
-        uint32_t ReadCountPrefix(uint8_t*& data, FieldKind kind);
+        uint32_t ReadCountPrefix(const uint8_t*& data, FieldKind kind);
 
-        // write count prefix to stream
-        void WriteCountPrefix(std::ostream& stream, uint32_t count, FieldKind kind);
+        // write count prefix to buffer
+        void WriteCountPrefix(IoUtils::MemoryWriter& out, uint32_t count, FieldKind kind);
     } // namespace FieldIO
 } // namespace AMT
@@ -0,0 +1,251 @@
+#include "pch.h"
+#include "FieldProgram.h"
+#include "FieldIO.h"
+#include <stdexcept>
+#include <unordered_map>
+
+namespace AMT
+{
+    // Interpreter frames a container needs on top of its parent's
+    static uint32_t GetFrameCost(const FieldDef& field, bool primitiveElement)
+    {
+        switch (field.kind)
+        {
+            case FieldKind::Struct:
+            case FieldKind::OptionalBitfield:
+                return 1;
+            case FieldKind::Array:
+            case FieldKind::FixedArray:
+                return primitiveElement ? 1 : 2; // struct elements get a frame of their own
+            default:
+                return 0;
+        }
+    }
+
+    // Size of a value that always takes the same number of bytes, 0 if it doesn't
+    static uint32_t GetFixedSize(const FieldDef& field)
+    {
+        switch (field.kind)
+        {
+            case FieldKind::UInt8:
+            case FieldKind::Int8:
+                return 1;
+            case FieldKind::UInt16:
+            case FieldKind::Int16:
+                return 2;
+            case FieldKind::UInt32:
+            case FieldKind::Int32:
+            case FieldKind::Float:
+            case FieldKind::Hash:
+                return 4;
+            case FieldKind::Enum:
+                return FieldIO::CountPrefixSize(field.enumBaseKind);
+            default:
+                return 0;
+        }
+    }
+
+    static uint32_t HashEnumName(std::string_view name)
+    {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (char c : name)
+        {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    EnumTable::EnumTable(SchemaSpan<EnumValue> values)
+    {
+        if (values.empty())
+            return;
+
+        int64_t minValue = values[0].value;
+        int64_t maxValue = values[0].value;
+        for (const auto& ev : values)
+        {
+            minValue = std::min<int64_t>(minValue, ev.value);
+            maxValue = std::max<int64_t>(maxValue, ev.value);
+        }
+
+        m_MinValue = minValue;
+        m_Dense = static_cast<uint64_t>(maxValue) - static_cast<uint64_t>(minValue) < MaxDenseRange;
+        if (m_Dense)
+        {
+            m_ByValue.resize(static_cast<size_t>(maxValue - minValue) + 1, nullptr);
+            for (const auto& ev : values)
+            {
+                auto& entry = m_ByValue[static_cast<size_t>(ev.value - minValue)];
+                if (!entry)
+                    entry = &ev;
+            }
+        }
+        else
+        {
+            for (const auto& ev : values)
+            {
+                m_ByValue.push_back(&ev);
+            }
+            // Stable, so the first of equal values stays in front
+            std::stable_sort(m_ByValue.begin(), m_ByValue.end(), [](const EnumValue* a, const EnumValue* b) { return a->value < b->value; });
+        }
+
+        // At most half full
+        size_t numSlots = 8;
+        while (numSlots < values.size() * 2)
+        {
+            numSlots *= 2;
+        }
+        m_ByName.resize(numSlots);
+
+        for (const auto& ev : values)
+        {
+            uint32_t hash = HashEnumName(ev.name);
+            for (size_t i = hash & (numSlots - 1);; i = (i + 1) & (numSlots - 1))
+            {
+                NameSlot& slot = m_ByName[i];
+                if (!slot.entry)
+                {
+                    slot = {hash, &ev};
+                    break;
+                }
+                if (slot.hash == hash && slot.entry->name == ev.name)
+                    break;
+            }
+        }
+    }
+
+    const EnumValue* EnumTable::FindName(std::string_view name) const
+    {
+        if (m_ByName.empty())
+            return nullptr;
+
+        size_t mask = m_ByName.size() - 1;
+        uint32_t hash = HashEnumName(name);
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            const NameSlot& slot = m_ByName[i];
+            if (!slot.entry)
+                return nullptr;
+            if (slot.hash == hash && slot.entry->name == name)
+                return slot.entry;
+        }
+    }
+
+    const EnumValue* EnumTable::FindSorted(int64_t value) const
+    {
+        auto it = std::lower_bound(m_ByValue.begin(), m_ByValue.end(), value, [](const EnumValue* ev, int64_t v) { return ev->value < v; });
+        return it != m_ByValue.end() && (*it)->value == value ? *it : nullptr;
+    }
+
+    FieldProgram FieldProgram::Compile(SchemaSpan<FieldDef> fields)
+    {
+        FieldProgram program;
+        program.numFields = static_cast<uint32_t>(fields.size());
+
+        std::unordered_map<std::string_view, uint32_t> nameIndex;
+
+        struct PendingField
+        {
+            const FieldDef* field;
+            uint32_t depth; // frames in use above this field
+        };
+
+        // Laid out breadth first, so the children of every op end up next to each other
+        std::vector<PendingField> pending;
+        for (const auto& field : fields)
+        {
+            pending.push_back({&field, 0});
+        }
+
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            const FieldDef& field = *pending[i].field;
+
+            FieldOp op;
+            op.kind = field.kind;
+            op.countKind = field.kind == FieldKind::Enum ? field.enumBaseKind : field.countKind;
+
+            auto [it, inserted] = nameIndex.try_emplace(field.name, static_cast<uint32_t>(program.names.size()));
+            if (inserted)
+                program.names.emplace_back(field.name);
+            op.name = it->second;
+
+            if (field.trackedAsHash)
+                op.flags |= FieldOpFlag_TrackedAsHash;
+            if (field.trackedAsArchive)
+                op.flags |= FieldOpFlag_TrackedAsArchive;
+
+            bool primitiveElement = field.children.size() == 1 && field.children[0].name.empty();
+            if ((field.kind == FieldKind::Array || field.kind == FieldKind::FixedArray) && primitiveElement)
+                op.flags |= FieldOpFlag_PrimitiveElement;
+            if (field.kind == FieldKind::Array && field.arrayElementsAreTrackedHashes)
+                op.flags |= FieldOpFlag_ElementsAreTrackedHashes;
+
+            if (field.kind == FieldKind::FixedArray)
+                op.count = static_cast<uint32_t>(field.fixedCount);
+            else if (field.kind == FieldKind::Placeholder)
+                op.count = static_cast<uint32_t>(field.placeholderSize);
+
+            if (field.kind == FieldKind::Enum)
+            {
+                op.enumTable = static_cast<uint32_t>(program.enumTables.size());
+                program.enumTables.emplace_back(field.enumValues);
+            }
+
+            if (field.kind == FieldKind::OptionalBitfield && field.children.size() > 32)
+                throw std::runtime_error("Bitfield " + std::string(field.name) + " has more than 32 fields");
+
+            uint32_t depth = pending[i].depth + GetFrameCost(field, primitiveElement);
+            if (depth > MaxDepth)
+                throw std::runtime_error("Field " + std::string(field.name) + " is nested too deeply");
+
+            op.firstChild = static_cast<uint32_t>(pending.size());
+            op.numChildren = static_cast<uint32_t>(field.children.size());
+            for (const auto& child : field.children)
+            {
+                pending.push_back({&child, depth});
+            }
+
+            program.ops.push_back(op);
+        }
+
+        // Give every field its member index in the object formed by its siblings
+        auto assignSlots = [&](uint32_t first, uint32_t count)
+        {
+            std::unordered_map<uint32_t, uint32_t> slots;
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                auto [it, inserted] = slots.try_emplace(program.ops[i].name, static_cast<uint32_t>(slots.size()));
+                program.ops[i].slot = it->second;
+            }
+            return static_cast<uint32_t>(slots.size());
+        };
+
+        program.numSlots = assignSlots(0, program.numFields);
+        for (auto& op : program.ops)
+        {
+            op.numSlots = assignSlots(op.firstChild, op.numChildren);
+        }
+
+        // Lay out lists of plain values up front, so they can skip the interpreter
+        program.fixedLayout = true;
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < program.numFields; i++)
+        {
+            uint32_t size = GetFixedSize(fields[i]);
+            if (size == 0)
+            {
+                program.fixedLayout = false;
+                break;
+            }
+            program.ops[i].offset = offset;
+            offset += size;
+        }
+        if (program.fixedLayout)
+            program.fixedSize = offset;
+
+        return program;
+    }
+} // namespace AMT
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "FieldDef.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AMT
+{
+    enum FieldOpFlags : uint8_t
+    {
+        FieldOpFlag_TrackedAsHash            = 1 << 0,
+        FieldOpFlag_TrackedAsArchive         = 1 << 1,
+        FieldOpFlag_PrimitiveElement         = 1 << 2, // array element is the single unnamed child
+        FieldOpFlag_ElementsAreTrackedHashes = 1 << 3
+    };
+
+    // Lookups for one enum field, both ways. Values that form a small range are indexed
+    // directly, others are binary searched. Names go through a hash table. Entries point
+    // into the static schema table; where a value or name is listed twice the first wins.
+    class EnumTable
+    {
+    public:
+        explicit EnumTable(SchemaSpan<EnumValue> values);
+
+        // Entry for a raw value, null if the enum doesn't have it
+        const EnumValue* FindValue(int64_t value) const
+        {
+            if (m_Dense)
+            {
+                uint64_t i = static_cast<uint64_t>(value) - static_cast<uint64_t>(m_MinValue);
+                return i < m_ByValue.size() ? m_ByValue[i] : nullptr;
+            }
+            return FindSorted(value);
+        }
+
+        // Entry for a name, null if the enum doesn't have it
+        const EnumValue* FindName(std::string_view name) const;
+
+    private:
+        const EnumValue* FindSorted(int64_t value) const;
+
+        struct NameSlot
+        {
+            uint32_t hash = 0;
+            const EnumValue* entry = nullptr;
+        };
+
+        // Largest value range that gets a direct index
+        static constexpr uint64_t MaxDenseRange = 256;
+
+        bool m_Dense = false;
+        int64_t m_MinValue = 0;
+        std::vector<const EnumValue*> m_ByValue; // value - m_MinValue if dense, sorted by value otherwise
+        std::vector<NameSlot> m_ByName;          // open addressing, power of two size
+    };
+
+    // A field lowered from a FieldDef. The children of an op are stored next to each
+    // other in the program, so a container only needs their range.
+    struct FieldOp
+    {
+        FieldKind kind;
+        FieldKind countKind;    // count prefix of String/Array, base type of Enum
+        uint8_t flags = 0;
+        uint32_t name = 0;      // index into FieldProgram::names
+        uint32_t firstChild = 0;
+        uint32_t numChildren = 0;
+        uint32_t count = 0;     // FixedArray element count, Placeholder size (0 = rest of the object)
+        uint32_t enumTable = 0; // index into FieldProgram::enumTables
+        uint32_t offset = 0;    // position in the record, for fixed layout programs
+        uint32_t slot = 0;      // member index in the parent object
+        uint32_t numSlots = 0;  // members of the object the children make up
+
+        bool HasFlag(uint8_t flag) const { return (flags & flag) != 0; }
+    };
+
+    // A field list compiled into a flat op array. The top level fields are ops [0, numFields).
+    // Fields that share a name (e.g. padding) share a member slot, the last one read wins.
+    struct FieldProgram
+    {
+        // Deepest container nesting the interpreters keep track of
+        static constexpr uint32_t MaxDepth = 16;
+
+        std::vector<FieldOp> ops;
+        std::vector<std::string> names;
+        std::vector<EnumTable> enumTables;
+        uint32_t numFields = 0;
+        uint32_t numSlots = 0;  // members of the object the top level fields make up
+
+        // Set when every field is a plain value of constant size, the fields then sit at
+        // fixed offsets in a record of fixedSize bytes
+        bool fixedLayout = false;
+        uint32_t fixedSize = 0;
+
+        const std::string& GetName(const FieldOp& op) const { return names[op.name]; }
+
+        static FieldProgram Compile(SchemaSpan<FieldDef> fields);
+    };
+} // namespace AMT
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace AMT
+{
+    enum class ValueType : uint8_t
+    {
+        Absent,  // optional or missing field
+        UInt,
+        Int,
+        Float,
+        Hash,    // str holds the name it was given as, if any
+        String,
+        Bytes,   // placeholder data
+        Array,
+        Object
+    };
+
+    struct FieldMember;
+
+    // A decoded field. Values are allocated from an Arena and laid out by the schema: the
+    // members of an object are indexed by FieldOp::slot and their names point into the
+    // FieldProgram, so nothing here owns memory.
+    struct FieldValue
+    {
+        ValueType type = ValueType::Absent;
+        uint32_t size = 0; // elements, members or chars/bytes
+
+        union
+        {
+            uint64_t u = 0;
+            int64_t i;
+            double f;
+        };
+
+        union
+        {
+            const char* str = nullptr;
+            const uint8_t* bytes;
+            FieldValue* elements;
+            FieldMember* members;
+        };
+
+        bool IsPresent() const { return type != ValueType::Absent; }
+    };
+
+    struct FieldMember
+    {
+        const std::string* name = nullptr;
+        FieldValue value;
+    };
+} // namespace AMT
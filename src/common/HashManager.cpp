@@ -1,18 +1,31 @@
 #include "pch.h"
 #include "HashManager.h"
-#include <iomanip>
-#include <sstream>
+#include "JobScheduler.h"
+#include "Stats.h"
+#include <array>
 
 namespace AMT 
 {
+    // ASCII lowercase, independent of the locale
+    static constexpr auto LowercaseTable = []
+    {
+        std::array<uint8_t, 256> table{};
+        for (int c = 0; c < 256; c++)
+        {
+            table[c] = static_cast<uint8_t>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+        }
+        return table;
+    }();
+
+
     // https://en.wikipedia.org/wiki/Jenkins_hash_function
-    uint32_t joaat(const uint8_t *key, size_t length)
+    // joaat of the lowercase string, without making a lowercase copy
+    static uint32_t joaatLowercase(std::string_view str)
     {
-        size_t i = 0;
         uint32_t hash = 0;
-        while (i != length)
+        for (char ch : str)
         {
-            hash += key[i++];
+            hash += LowercaseTable[static_cast<uint8_t>(ch)];
             hash += hash << 10;
             hash ^= hash >> 6;
         }
@@ -22,46 +35,510 @@ namespace AMT
         return hash;
     }
 
-    uint32_t HashString(const std::string &str)
+
+    static bool EqualsIgnoreCase(std::string_view a, std::string_view b)
     {
-        return joaat(reinterpret_cast<const uint8_t *>(str.c_str()), str.length());
+        if (a.size() != b.size())
+            return false;
+
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (LowercaseTable[static_cast<uint8_t>(a[i])] != LowercaseTable[static_cast<uint8_t>(b[i])])
+                return false;
+        }
+        return true;
     }
 
 
-    uint32_t HashStringLowercase (const std::string &str)
+    // Hashes are well mixed already, this only spreads runs of similar ones
+    static size_t SlotIndex(uint32_t hash, size_t mask)
     {
-        std::string key = str;
-        std::transform(key.begin(), key.end(), key.begin(), [] (unsigned char c) { return std::tolower(c); });
-        return HashString(key);
+        uint32_t h = hash * 0x9E3779B1u;
+        return (h ^ (h >> 16)) & mask;
     }
 
 
-    uint32_t HashManager::AddHash(const std::string &str)
+    const HashManager::Slot *HashManager::FindSlot(uint32_t hash) const
+    {
+        if (m_Slots.empty())
+            return nullptr;
+
+        size_t mask = m_Slots.size() - 1;
+        for (size_t i = SlotIndex(hash, mask);; i = (i + 1) & mask)
+        {
+            const Slot &slot = m_Slots[i];
+            if (!slot.str)
+                return nullptr;
+            if (slot.hash == hash)
+                return &slot;
+        }
+    }
+
+
+    void HashManager::Grow()
+    {
+        std::vector<Slot> old = std::move(m_Slots);
+        m_Slots.assign(old.empty() ? 1024 : old.size() * 2, Slot{0, 0, nullptr});
+
+        size_t mask = m_Slots.size() - 1;
+        for (const Slot &slot : old)
+        {
+            if (!slot.str)
+                continue;
+
+            size_t i = SlotIndex(slot.hash, mask);
+            while (m_Slots[i].str)
+                i = (i + 1) & mask;
+            m_Slots[i] = slot;
+        }
+    }
+
+
+    bool HashManager::Insert(uint32_t hash, std::string_view str)
+    {
+        // Nothing to do if the name is known already
+        if (const Slot *known = FindSlot(hash))
+        {
+            if (std::string_view(known->str, known->length) == str)
+                return false;
+        }
+        else
+        {
+            std::string_view cached;
+            if (FindCacheString(hash, cached) && cached == str)
+                return false;
+        }
+
+        // Kept at most 70% full, so probe runs stay short
+        if ((m_NumHashes + 1) * 10 > m_Slots.size() * 7)
+            Grow();
+
+        size_t mask = m_Slots.size() - 1;
+        size_t i = SlotIndex(hash, mask);
+        while (m_Slots[i].str && m_Slots[i].hash != hash)
+            i = (i + 1) & mask;
+
+        Slot &slot = m_Slots[i];
+        if (!slot.str)
+            m_NumHashes++;
+
+        // Strings are null terminated, so an empty one still gets a valid pointer
+        char *copy = static_cast<char *>(m_Strings.Allocate(str.size() + 1, 1));
+        memcpy(copy, str.data(), str.size());
+        copy[str.size()] = '\0';
+        slot = {hash, static_cast<uint32_t>(str.size()), copy};
+        return true;
+    }
+
+
+    void HashManager::Reserve(size_t count)
+    {
+        while (count * 10 > m_Slots.size() * 7)
+            Grow();
+    }
+
+
+    std::vector<HashManager::HashCollision> HashManager::AddHashes(const char *text, size_t size, uint32_t numWorkers)
+    {
+        struct Line
+        {
+            uint32_t hash;
+            uint32_t length;
+            const char *str;
+        };
+
+        // Chunks end after a line break, so no line is split between them
+        const size_t chunkSize = 256 * 1024;
+        std::vector<size_t> chunkStarts{0};
+        while (chunkStarts.back() + chunkSize < size)
+        {
+            const char *end = static_cast<const char *>(memchr(text + chunkStarts.back() + chunkSize, '\n', size - chunkStarts.back() - chunkSize));
+            if (!end)
+                break;
+            chunkStarts.push_back(end + 1 - text);
+        }
+        chunkStarts.push_back(size);
+
+        // Lines are split and hashed in parallel
+        size_t numChunks = chunkStarts.size() - 1;
+        std::vector<std::vector<Line>> chunks(numChunks);
+        JobScheduler::ParallelFor(numChunks, numWorkers, [&](size_t chunk)
+        {
+            const char *pos = text + chunkStarts[chunk];
+            const char *end = text + chunkStarts[chunk + 1];
+            while (pos < end)
+            {
+                const char *lineEnd = static_cast<const char *>(memchr(pos, '\n', end - pos));
+                const char *next = lineEnd ? lineEnd + 1 : end;
+                if (!lineEnd)
+                    lineEnd = end;
+                if (lineEnd > pos && lineEnd[-1] == '\r')
+                    lineEnd--;
+
+                std::string_view str(pos, lineEnd - pos);
+                chunks[chunk].push_back({joaatLowercase(str), static_cast<uint32_t>(str.size()), str.data()});
+                pos = next;
+            }
+        }, 1);
+
+        size_t numLines = 0;
+        for (const auto &lines : chunks)
+        {
+            numLines += lines.size();
+        }
+
+        // Then added in file order, so later lines still replace earlier ones
+        std::vector<HashCollision> collisions;
+        if (m_ReadOnly)
+            return collisions;
+
+        Reserve(m_NumHashes + numLines);
+        for (const auto &lines : chunks)
+        {
+            for (const Line &line : lines)
+            {
+                std::string_view str(line.str, line.length);
+                std::string_view known;
+                if (FindString(line.hash, known) && !EqualsIgnoreCase(known, str))
+                    collisions.push_back({line.hash, std::string(known), std::string(str)});
+
+                if (Insert(line.hash, str))
+                    m_Learned.push_back(line.hash);
+            }
+        }
+        return collisions;
+    }
+
+
+    uint32_t HashManager::AddHash(std::string_view str)
     {
         uint32_t hash = StringToHash(str);
-        m_HashTable[hash] = str;
+        if (!m_ReadOnly && Insert(hash, str))
+            m_Learned.push_back(hash);
 
         return hash;
     }
 
 
-    uint32_t HashManager::StringToHash(const std::string &str) const
+    uint32_t HashManager::StringToHash(std::string_view str) const
+    {
+        return joaatLowercase(str);
+    }
+
+
+    bool HashManager::FindCacheString(uint32_t hash, std::string_view &str) const
+    {
+        const uint32_t *end = m_CacheHashes + m_NumCacheHashes;
+        const uint32_t *it = std::lower_bound(m_CacheHashes, end, hash);
+        if (it == end || *it != hash)
+            return false;
+
+        size_t index = it - m_CacheHashes;
+        uint32_t offset = m_CacheOffsets[index];
+        str = std::string_view(m_CacheStrings + offset, m_CacheOffsets[index + 1] - offset - 1);
+        return true;
+    }
+
+
+    bool HashManager::FindString(uint32_t hash, std::string_view &str) const
     {
-        return HashStringLowercase(str);
+        if (const Slot *slot = FindSlot(hash))
+        {
+            str = std::string_view(slot->str, slot->length);
+            return true;
+        }
+        return FindCacheString(hash, str);
+    }
+
+
+    void HashManager::FormatHash(uint32_t hash, char *out)
+    {
+        static constexpr char digits[] = "0123456789abcdef";
+
+        out[0] = '0';
+        out[1] = 'x';
+        for (int i = 0; i < 8; i++)
+        {
+            out[2 + i] = digits[(hash >> (28 - i * 4)) & 0xF];
+        }
+    }
+
+
+    std::string_view HashManager::HashToString(uint32_t hash, HashText &text) const
+    {
+        std::string_view str;
+        bool found = FindString(hash, str);
+        if (Stats::IsEnabled())
+        {
+            Stats::Counters& counters = Stats::GetThreadCounters();
+            if (found)
+                counters.hashHits++;
+            else
+                counters.hashMisses++;
+        }
+        if (found)
+            return str;
+
+        FormatHash(hash, text.data);
+        return std::string_view(text.data, sizeof(text.data));
     }
 
 
     std::string HashManager::HashToString(uint32_t hash) const
     {
-        if (m_HashTable.count(hash))
+        HashText text;
+        return std::string(HashToString(hash, text));
+    }
+
+
+    // Cache file layout, all little endian:
+    //   CacheHeader
+    //   uint32_t hashes[numHashes]         ascending
+    //   uint32_t offsets[numHashes + 1]    of each null terminated name in the strings
+    //   char strings[stringsSize]
+    //   then any number of appended names: uint32_t hash, uint32_t length, char name[length]
+    struct CacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t numHashes;
+        uint32_t stringsSize;
+        uint64_t listSize;      // size of the word list it was built from
+    };
+
+    static constexpr uint32_t CacheMagic = 0x48544D41; // "AMTH"
+    static constexpr uint32_t CacheVersion = 1;
+
+
+    void HashManager::CloseCache()
+    {
+        m_Cache.Close();
+        m_CacheHashes = nullptr;
+        m_CacheOffsets = nullptr;
+        m_CacheStrings = nullptr;
+        m_NumCacheHashes = 0;
+        m_NumCacheRecords = 0;
+    }
+
+
+    // Copies the names only the mapping has into the table and closes it, so the cache
+    // file can be replaced without losing anything if that fails
+    void HashManager::DetachCache()
+    {
+        const uint32_t *hashes = m_CacheHashes;
+        uint32_t numHashes = m_NumCacheHashes;
+        std::vector<std::pair<uint32_t, std::string_view>> names;
+        names.reserve(numHashes);
+        for (uint32_t i = 0; i < numHashes; i++)
+        {
+            std::string_view str;
+            if (!FindSlot(hashes[i]) && FindCacheString(hashes[i], str))
+                names.emplace_back(hashes[i], str);
+        }
+
+        // With the cache out of the way Insert doesn't find them there
+        m_CacheHashes = nullptr;
+        m_NumCacheHashes = 0;
+        Reserve(m_NumHashes + names.size());
+        for (const auto &[hash, str] : names)
+        {
+            Insert(hash, str);
+        }
+        CloseCache();
+    }
+
+
+    bool HashManager::LoadCache(const std::string &cachePath, const std::string &listPath)
+    {
+        CloseCache();
+
+        // Rebuilt whenever the list is edited
+        std::error_code ec;
+        uint64_t listSize = std::filesystem::file_size(listPath, ec);
+        if (ec)
+            return false;
+        auto listTime = std::filesystem::last_write_time(listPath, ec);
+        if (ec)
+            return false;
+        auto cacheTime = std::filesystem::last_write_time(cachePath, ec);
+        if (ec || cacheTime < listTime)
+            return false;
+
+        if (!m_Cache.Open(cachePath) || m_Cache.GetSize() < sizeof(CacheHeader))
+        {
+            CloseCache();
+            return false;
+        }
+
+        const uint8_t *data = m_Cache.GetData();
+        size_t size = m_Cache.GetSize();
+
+        CacheHeader header;
+        memcpy(&header, data, sizeof(header));
+
+        size_t tablesSize = (size_t(header.numHashes) * 2 + 1) * 4;
+        if (header.magic != CacheMagic || header.version != CacheVersion || header.listSize != listSize ||
+            size - sizeof(header) < tablesSize + header.stringsSize)
+        {
+            CloseCache();
+            return false;
+        }
+
+        const uint32_t *hashes = reinterpret_cast<const uint32_t *>(data + sizeof(header));
+        const uint32_t *offsets = hashes + header.numHashes;
+
+        // One pass over the tables, so lookups can trust them
+        for (uint32_t i = 0; i < header.numHashes; i++)
+        {
+            if ((i > 0 && hashes[i] <= hashes[i - 1]) || offsets[i] >= offsets[i + 1])
+            {
+                CloseCache();
+                return false;
+            }
+        }
+        if (offsets[0] != 0 || offsets[header.numHashes] != header.stringsSize)
+        {
+            CloseCache();
+            return false;
+        }
+
+        m_CacheHashes = hashes;
+        m_CacheOffsets = offsets;
+        m_CacheStrings = reinterpret_cast<const char *>(offsets + header.numHashes + 1);
+        m_NumCacheHashes = header.numHashes;
+
+        // Names learned by earlier runs, a partly written one at the end is ignored
+        size_t pos = sizeof(header) + tablesSize + header.stringsSize;
+        while (size - pos >= 8)
+        {
+            uint32_t hash, length;
+            memcpy(&hash, data + pos, 4);
+            memcpy(&length, data + pos + 4, 4);
+            if (size - pos - 8 < length)
+                break;
+
+            Insert(hash, std::string_view(reinterpret_cast<const char *>(data + pos + 8), length));
+            m_NumCacheRecords++;
+            pos += 8 + length;
+        }
+
+        m_Learned.clear();
+        return true;
+    }
+
+
+    void HashManager::SaveCache(const std::string &cachePath, const std::string &listPath)
+    {
+        std::error_code ec;
+        uint64_t listSize = std::filesystem::file_size(listPath, ec);
+        if (ec)
+            return;
+
+        // A name may have been replaced more than once, its last form is saved
+        std::sort(m_Learned.begin(), m_Learned.end());
+        m_Learned.erase(std::unique(m_Learned.begin(), m_Learned.end()), m_Learned.end());
+
+        // Appended names are read one by one at startup, so once there are many of them
+        // the whole file is rebuilt
+        bool rebuild = !m_CacheHashes || m_NumCacheRecords + m_Learned.size() > m_NumCacheHashes / 4 + 4096;
+        if (!rebuild && m_Learned.empty())
+            return;
+
+        // The mapping has to go before the file can be replaced or extended, its names are
+        // moved into the table first. Views into it end here.
+        DetachCache();
+
+        IoUtils::MemoryWriter out;
+        if (rebuild)
+        {
+            std::vector<std::pair<uint32_t, std::string_view>> names;
+            names.reserve(m_NumHashes);
+            for (const Slot &slot : m_Slots)
+            {
+                if (slot.str)
+                    names.emplace_back(slot.hash, std::string_view(slot.str, slot.length));
+            }
+            std::sort(names.begin(), names.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+            CacheHeader header{CacheMagic, CacheVersion, static_cast<uint32_t>(names.size()), 0, listSize};
+            size_t headerPos = out.Reserve(sizeof(header));
+            for (const auto &[hash, str] : names)
+            {
+                IoUtils::WriteData(out, hash);
+            }
+
+            uint32_t offset = 0;
+            for (const auto &[hash, str] : names)
+            {
+                IoUtils::WriteData(out, offset);
+                offset += static_cast<uint32_t>(str.size() + 1);
+            }
+            IoUtils::WriteData(out, offset);
+
+            for (const auto &[hash, str] : names)
+            {
+                out.Write(str.data(), str.size());
+                IoUtils::WriteData<uint8_t>(out, 0);
+            }
+
+            header.stringsSize = offset;
+            out.Patch(headerPos, header);
+        }
+        else
         {
-            return m_HashTable.at(hash);
+            for (uint32_t hash : m_Learned)
+            {
+                std::string_view str;
+                FindString(hash, str);
+                IoUtils::WriteData(out, hash);
+                IoUtils::WriteData(out, static_cast<uint32_t>(str.size()));
+                out.Write(str.data(), str.size());
+            }
         }
 
-        std::stringstream ss;
-        ss << "0x" << std::setfill('0') << std::setw(8) << std::hex << hash;
+        if (rebuild)
+        {
+            // Written next to it first, so an interrupted run can't leave half a cache
+            std::string tempPath = cachePath + ".tmp";
+            std::ofstream file(tempPath, std::ios_base::binary | std::ios_base::trunc);
+            bool created = file.is_open();
+            out.WriteTo(file);
+            file.close();
+            if (file.fail())
+            {
+                if (created)
+                    std::filesystem::remove(tempPath, ec);
+                throw std::runtime_error("Can't write " + tempPath);
+            }
+
+            std::filesystem::rename(tempPath, cachePath, ec);
+            if (ec)
+            {
+                std::string error = ec.message();
+                std::filesystem::remove(tempPath, ec);
+                throw std::runtime_error("Can't replace " + cachePath + ": " + error);
+            }
+        }
+        else
+        {
+            // A record cut short would hide the ones appended after it, so a failed
+            // append is undone
+            uint64_t oldSize = std::filesystem::file_size(cachePath, ec);
+            std::ofstream file(cachePath, std::ios_base::binary | std::ios_base::app);
+            out.WriteTo(file);
+            file.close();
+            if (file.fail())
+            {
+                if (!ec)
+                    std::filesystem::resize_file(cachePath, oldSize, ec);
+                throw std::runtime_error("Can't write " + cachePath);
+            }
+        }
 
-        return ss.str();
+        // Saved, so the table can go back to being read from the file
+        m_Slots.clear();
+        m_NumHashes = 0;
+        LoadCache(cachePath, listPath);
     }
 
 
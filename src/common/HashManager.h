@@ -3,18 +3,56 @@
 #include <cstdint>
 #include <string>
 #include <memory>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
+#include "Arena.h"
 #include "BaseTypes.h"
+#include "MappedFile.h"
 
 namespace AMT 
 {
 
     class HashManager
     {
+        // Open addressing with linear probing. Names live in m_Strings, so the table
+        // itself is a flat array of small entries.
+        struct Slot
+        {
+            uint32_t hash;
+            uint32_t length;
+            const char *str;    // null if the slot is empty
+        };
+
         inline static std::unique_ptr<HashManager> sm_Instance;
-        std::unordered_map<uint32_t, std::string> m_HashTable;
+        std::vector<Slot> m_Slots;
+        uint32_t m_NumHashes = 0;
+        Arena m_Strings{256 * 1024};
+        bool m_ReadOnly = false;
+
+        // Names loaded from the cache stay in the mapping, sorted by hash. m_Slots
+        // only holds the names added after it, which take precedence.
+        MappedFile m_Cache;
+        const uint32_t *m_CacheHashes = nullptr;
+        const uint32_t *m_CacheOffsets = nullptr;   // numCacheHashes + 1, into m_CacheStrings
+        const char *m_CacheStrings = nullptr;
+        uint32_t m_NumCacheHashes = 0;
+        uint32_t m_NumCacheRecords = 0;             // appended to the cache after it was built
+        std::vector<uint32_t> m_Learned;            // added since the cache was loaded
+
+        const Slot *FindSlot(uint32_t hash) const;
+        bool FindCacheString(uint32_t hash, std::string_view &str) const;
+        void Grow();
+        bool Insert(uint32_t hash, std::string_view str);
+        void CloseCache();
+        void DetachCache();
 
     public:
+        // Room for the 0x%08x form of a hash
+        struct HashText
+        {
+            char data[10];
+        };
+
         inline static HashManager *
         Instance()
         {
@@ -25,11 +63,55 @@ namespace AMT
             return sm_Instance.get();
         }
 
-        uint32_t AddHash(const std::string &str);
+        // A later name with the same hash replaces the earlier one
+        uint32_t AddHash(std::string_view str);
+
+        // Two different names with the same hash
+        struct HashCollision
+        {
+            uint32_t hash;
+            std::string previous;
+            std::string name;
+        };
+
+        // Adds every line of a word list, hashing the lines on up to numWorkers threads
+        // (0 = one per core). Lines replace each other like AddHash calls in file order,
+        // every name that replaces a different one (other than by case) is returned.
+        std::vector<HashCollision> AddHashes(const char *text, size_t size, uint32_t numWorkers = 0);
+
+        // Make room for count names without growing the table
+        void Reserve(size_t count);
+
+        // While read-only, AddHash only computes the hash and leaves the table
+        // untouched, so it can be shared between threads without locking.
+        void SetReadOnly(bool readOnly) { m_ReadOnly = readOnly; }
+
+        // Name of a hash. The view stays valid until the next LoadCache or SaveCache, which
+        // may unmap the cache it points into.
+        bool FindString(uint32_t hash, std::string_view &str) const;
+
+        // Name of a hash, or its 0x%08x form written to text if it has none.
+        // Allocates nothing.
+        std::string_view HashToString(uint32_t hash, HashText &text) const;
 
         // Functins to convert between hashes and strings
         std::string HashToString(uint32_t hash) const;
-        uint32_t StringToHash(const std::string &str) const;
+        uint32_t StringToHash(std::string_view str) const;
+
+        size_t GetNumHashes() const { return m_NumHashes + m_NumCacheHashes; }
+
+        // The dictionary built from a word list (e.g. Hashes.txt) is kept in a binary
+        // cache, together with the names learned since. Returns false if there is no
+        // cache for the list or the list has changed since it was built.
+        bool LoadCache(const std::string &cachePath, const std::string &listPath);
+
+        // Adds the names learned since LoadCache to the cache, or writes the whole
+        // dictionary if it wasn't loaded from one. Throws if the file can't be written,
+        // the names stay in memory then and the cache on disk is left as it was.
+        void SaveCache(const std::string &cachePath, const std::string &listPath);
+
+        // Writes the 10 chars of the 0x%08x form of hash to out
+        static void FormatHash(uint32_t hash, char *out);
     };
 
     class JoaatHash
@@ -55,7 +137,12 @@ namespace AMT
 
         inline void FromJson(const ordered_json &j)
         {
-            std::string hashStr = j;
+            FromString(j.get_ref<const std::string &>());
+        }
+
+        // "0x" followed by 8 hex digits is a hash value, anything else a name
+        inline void FromString(const std::string &hashStr)
+        {
             try
             {
                 if (hashStr.length() == std::string("0x????????").size() && hashStr[0] == '0' && hashStr[1] == 'x')
@@ -0,0 +1,553 @@
+#include "pch.h"
+#include "HexUtils.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define AMT_HEX_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AMT_TARGET(isa)
+#else
+#define AMT_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace AMT
+{
+    namespace HexUtils
+    {
+        struct HexPairs
+        {
+            char chars[512];
+        };
+
+        // The two digits of every byte value
+        static constexpr HexPairs MakeHexPairs()
+        {
+            constexpr char digits[] = "0123456789abcdef";
+            HexPairs pairs{};
+            for (int i = 0; i < 256; i++)
+            {
+                pairs.chars[i * 2] = digits[i >> 4];
+                pairs.chars[i * 2 + 1] = digits[i & 0xF];
+            }
+            return pairs;
+        }
+
+        static constexpr HexPairs s_HexPairs = MakeHexPairs();
+
+        static void EncodeHexScalar(const uint8_t* data, size_t size, char* out)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                memcpy(out + i * 2, &s_HexPairs.chars[data[i] * 2], 2);
+            }
+        }
+
+        static void EncodeHexSpacedScalar(const uint8_t* data, size_t size, char* out)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                memcpy(out, &s_HexPairs.chars[data[i] * 2], 2);
+                out[2] = ' ';
+                out += 3;
+            }
+        }
+
+        // Value of a hex digit, -1 if c isn't one
+        static int HexDigitValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+
+        // The chars istream skips between numbers
+        static bool IsHexSeparator(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+        }
+
+        // Parses unseparated pairs from pos, the start of a pair, on
+        static bool DecodeHexScalar(const char* text, size_t size, size_t pos, uint8_t* out, size_t& errorPos)
+        {
+            for (; pos < size; pos += 2)
+            {
+                int hi = HexDigitValue(text[pos]);
+                if (hi < 0)
+                {
+                    errorPos = pos;
+                    return false;
+                }
+                int lo = pos + 1 < size ? HexDigitValue(text[pos + 1]) : -1;
+                if (lo < 0)
+                {
+                    errorPos = pos + 1;
+                    return false;
+                }
+                out[pos / 2] = static_cast<uint8_t>((hi << 4) | lo);
+            }
+            return true;
+        }
+
+        // Parses tokens from pos, which isn't inside one, on. outSize holds the bytes already done.
+        static bool DecodeHexSpacedScalar(const char* text, size_t size, size_t pos, uint8_t* out, size_t& outSize, size_t& errorPos)
+        {
+            size_t n = outSize;
+            for (;;)
+            {
+                while (pos < size && IsHexSeparator(text[pos]))
+                    pos++;
+                if (pos == size)
+                    break;
+
+                int value = HexDigitValue(text[pos]);
+                if (value < 0)
+                {
+                    errorPos = pos;
+                    return false;
+                }
+                pos++;
+
+                int lo = pos < size ? HexDigitValue(text[pos]) : -1;
+                if (lo >= 0)
+                {
+                    value = (value << 4) | lo;
+                    pos++;
+                }
+                out[n++] = static_cast<uint8_t>(value);
+
+                // A third digit would not fit in the byte
+                if (pos < size && !IsHexSeparator(text[pos]))
+                {
+                    errorPos = pos;
+                    return false;
+                }
+            }
+            outSize = n;
+            return true;
+        }
+
+#ifdef AMT_HEX_X64
+        // Shuffle masks that spread the digit pairs of 16 bytes over three 16 char blocks of
+        // "hh hh ...". lo and hi pick from the pairs of bytes 0-7 and 8-15, spaces fills the gaps.
+        struct SpacedMasks
+        {
+            int8_t lo[3][16];
+            int8_t hi[3][16];
+            int8_t spaces[3][16];
+        };
+
+        static constexpr SpacedMasks MakeSpacedMasks()
+        {
+            SpacedMasks masks{};
+            for (int block = 0; block < 3; block++)
+            {
+                for (int i = 0; i < 16; i++)
+                {
+                    int pos = block * 16 + i;
+                    int byte = pos / 3;
+                    int digit = pos % 3;
+
+                    masks.lo[block][i] = -1;
+                    masks.hi[block][i] = -1;
+                    masks.spaces[block][i] = digit == 2 ? ' ' : 0;
+                    if (digit == 2)
+                        continue;
+
+                    if (byte < 8)
+                        masks.lo[block][i] = static_cast<int8_t>(byte * 2 + digit);
+                    else
+                        masks.hi[block][i] = static_cast<int8_t>((byte - 8) * 2 + digit);
+                }
+            }
+            return masks;
+        }
+
+        static constexpr SpacedMasks s_SpacedMasks = MakeSpacedMasks();
+
+        // SSE2 has no byte shuffle, so the digits are computed as n + '0' (+ 39 past 9)
+        static void EncodeHexSSE2(const uint8_t* data, size_t size, char* out)
+        {
+            const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+            const __m128i zero = _mm_set1_epi8('0');
+            const __m128i nine = _mm_set1_epi8(9);
+            const __m128i letterOffset = _mm_set1_epi8('a' - '0' - 10);
+
+            auto toDigits = [&](__m128i n)
+            {
+                __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(n, nine), letterOffset);
+                return _mm_add_epi8(_mm_add_epi8(n, zero), letters);
+            };
+
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i hi = toDigits(_mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+                __m128i lo = toDigits(_mm_and_si128(v, nibbleMask));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_unpacklo_epi8(hi, lo));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+            }
+            EncodeHexScalar(data + i, size - i, out + i * 2);
+        }
+
+        AMT_TARGET("ssse3")
+        static void EncodeHexSpacedSSSE3(const uint8_t* data, size_t size, char* out)
+        {
+            const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+            const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+            __m128i loMasks[3], hiMasks[3], spaces[3];
+            for (int b = 0; b < 3; b++)
+            {
+                loMasks[b] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_SpacedMasks.lo[b]));
+                hiMasks[b] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_SpacedMasks.hi[b]));
+                spaces[b] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_SpacedMasks.spaces[b]));
+            }
+
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+                __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, nibbleMask));
+                __m128i pairsLo = _mm_unpacklo_epi8(hi, lo);
+                __m128i pairsHi = _mm_unpackhi_epi8(hi, lo);
+
+                char* dst = out + i * 3;
+                for (int b = 0; b < 3; b++)
+                {
+                    __m128i block = _mm_or_si128(_mm_shuffle_epi8(pairsLo, loMasks[b]), _mm_shuffle_epi8(pairsHi, hiMasks[b]));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + b * 16), _mm_or_si128(block, spaces[b]));
+                }
+            }
+            EncodeHexSpacedScalar(data + i, size - i, out + i * 3);
+        }
+
+        // Same as the SSSE3 kernel, with each 128 bit lane working on its own 16 bytes
+        AMT_TARGET("avx2")
+        static void EncodeHexSpacedAVX2(const uint8_t* data, size_t size, char* out)
+        {
+            const __m256i digits = _mm256_setr_epi8(
+                '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+            const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+
+            __m256i loMasks[3], hiMasks[3], spaces[3];
+            for (int b = 0; b < 3; b++)
+            {
+                loMasks[b] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s_SpacedMasks.lo[b])));
+                hiMasks[b] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s_SpacedMasks.hi[b])));
+                spaces[b] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s_SpacedMasks.spaces[b])));
+            }
+
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbleMask));
+                __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, nibbleMask));
+                __m256i pairsLo = _mm256_unpacklo_epi8(hi, lo);
+                __m256i pairsHi = _mm256_unpackhi_epi8(hi, lo);
+
+                char* dst = out + i * 3;
+                for (int b = 0; b < 3; b++)
+                {
+                    __m256i block = _mm256_or_si256(_mm256_shuffle_epi8(pairsLo, loMasks[b]), _mm256_shuffle_epi8(pairsHi, hiMasks[b]));
+                    block = _mm256_or_si256(block, spaces[b]);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + b * 16), _mm256_castsi256_si128(block));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 48 + b * 16), _mm256_extracti128_si256(block, 1));
+                }
+            }
+            EncodeHexSpacedSSSE3(data + i, size - i, out + i * 3);
+        }
+
+        // Shuffle masks that gather the first and second digit of 16 pairs from the three 16
+        // char blocks they span, and the separator positions of each block
+        struct PairMasks
+        {
+            int8_t hi[3][16];
+            int8_t lo[3][16];
+            int separators[3];
+        };
+
+        static constexpr PairMasks MakePairMasks()
+        {
+            PairMasks masks{};
+            for (int block = 0; block < 3; block++)
+            {
+                for (int i = 0; i < 16; i++)
+                {
+                    int hiPos = i * 3;
+                    int loPos = i * 3 + 1;
+                    masks.hi[block][i] = hiPos / 16 == block ? static_cast<int8_t>(hiPos % 16) : -1;
+                    masks.lo[block][i] = loPos / 16 == block ? static_cast<int8_t>(loPos % 16) : -1;
+
+                    if ((block * 16 + i) % 3 == 2)
+                        masks.separators[block] |= 1 << i;
+                }
+            }
+            return masks;
+        }
+
+        static constexpr PairMasks s_PairMasks = MakePairMasks();
+
+        // Nibble values of 16 digit chars, false if any of them isn't a hex digit
+        AMT_TARGET("ssse3")
+        static bool DigitsToNibbles(__m128i c, __m128i& nibbles)
+        {
+            __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), c));
+            __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+            __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+            if (_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xFFFF)
+                return false;
+
+            nibbles = _mm_or_si128(
+                _mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+                _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+            return true;
+        }
+
+        AMT_TARGET("avx2")
+        static bool DigitsToNibbles(__m256i c, __m256i& nibbles)
+        {
+            __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+            __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+            __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+            if (_mm256_movemask_epi8(_mm256_or_si256(digit, letter)) != -1)
+                return false;
+
+            nibbles = _mm256_or_si256(
+                _mm256_and_si256(digit, _mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+                _mm256_and_si256(letter, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10))));
+            return true;
+        }
+
+        // Decodes whole 16 byte (48 char) blocks that are followed by more data, stopping at
+        // the first block that isn't valid. Returns the number of bytes decoded.
+        AMT_TARGET("ssse3")
+        static size_t DecodeHexBlocksSSSE3(const char* text, size_t size, uint8_t* out)
+        {
+            const __m128i space = _mm_set1_epi8(' ');
+
+            size_t n = 0;
+            for (; n * 3 + 48 <= size; n += 16)
+            {
+                const char* src = text + n * 3;
+                __m128i hi = _mm_setzero_si128();
+                __m128i lo = _mm_setzero_si128();
+                bool separated = true;
+                for (int b = 0; b < 3; b++)
+                {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + b * 16));
+                    int spaces = _mm_movemask_epi8(_mm_cmpeq_epi8(v, space));
+                    separated &= (spaces & s_PairMasks.separators[b]) == s_PairMasks.separators[b];
+
+                    hi = _mm_or_si128(hi, _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_PairMasks.hi[b]))));
+                    lo = _mm_or_si128(lo, _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_PairMasks.lo[b]))));
+                }
+
+                __m128i hiNibbles, loNibbles;
+                if (!separated || !DigitsToNibbles(hi, hiNibbles) || !DigitsToNibbles(lo, loNibbles))
+                    break;
+
+                // Nibbles are below 16, so the 16 bit shift can't carry into the next byte
+                __m128i bytes = _mm_or_si128(_mm_slli_epi16(hiNibbles, 4), loNibbles);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), bytes);
+            }
+            return n;
+        }
+
+        // Decodes 16 bytes (32 chars) at a time, stopping at the first block with a char
+        // that isn't a hex digit. Returns the number of bytes decoded.
+        AMT_TARGET("ssse3")
+        static size_t DecodeHexPairsSSSE3(const char* text, size_t size, uint8_t* out)
+        {
+            const __m128i evenMask = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i oddMask = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+
+            size_t n = 0;
+            for (; n * 2 + 32 <= size; n += 16)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + n * 2));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + n * 2 + 16));
+                __m128i hi = _mm_unpacklo_epi64(_mm_shuffle_epi8(a, evenMask), _mm_shuffle_epi8(b, evenMask));
+                __m128i lo = _mm_unpacklo_epi64(_mm_shuffle_epi8(a, oddMask), _mm_shuffle_epi8(b, oddMask));
+
+                __m128i hiNibbles, loNibbles;
+                if (!DigitsToNibbles(hi, hiNibbles) || !DigitsToNibbles(lo, loNibbles))
+                    break;
+
+                __m128i bytes = _mm_or_si128(_mm_slli_epi16(hiNibbles, 4), loNibbles);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), bytes);
+            }
+            return n;
+        }
+
+        // Two blocks at a time, one per 128 bit lane
+        AMT_TARGET("avx2")
+        static size_t DecodeHexBlocksAVX2(const char* text, size_t size, uint8_t* out)
+        {
+            const __m256i space = _mm256_set1_epi8(' ');
+
+            size_t n = 0;
+            for (; n * 3 + 96 <= size; n += 32)
+            {
+                const char* src = text + n * 3;
+                __m256i hi = _mm256_setzero_si256();
+                __m256i lo = _mm256_setzero_si256();
+                bool separated = true;
+                for (int b = 0; b < 3; b++)
+                {
+                    __m256i v = _mm256_inserti128_si256(
+                        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + b * 16))),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48 + b * 16)), 1);
+
+                    uint32_t separators = static_cast<uint32_t>(s_PairMasks.separators[b]) * 0x10001u;
+                    uint32_t spaces = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, space)));
+                    separated &= (spaces & separators) == separators;
+
+                    hi = _mm256_or_si256(hi, _mm256_shuffle_epi8(v, _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s_PairMasks.hi[b])))));
+                    lo = _mm256_or_si256(lo, _mm256_shuffle_epi8(v, _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s_PairMasks.lo[b])))));
+                }
+
+                __m256i hiNibbles, loNibbles;
+                if (!separated || !DigitsToNibbles(hi, hiNibbles) || !DigitsToNibbles(lo, loNibbles))
+                    break;
+
+                __m256i bytes = _mm256_or_si256(_mm256_slli_epi16(hiNibbles, 4), loNibbles);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + n), bytes);
+            }
+            return n + DecodeHexBlocksSSSE3(text + n * 3, size - n * 3, out + n);
+        }
+
+        static bool HasAVX2()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+                return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+        static bool HasSSSE3()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 9)) != 0;
+#else
+            return __builtin_cpu_supports("ssse3");
+#endif
+        }
+#endif
+
+        using EncodeFunc = void (*)(const uint8_t*, size_t, char*);
+
+        // Picks the widest kernel the CPU supports, once
+        static EncodeFunc GetSpacedEncoder()
+        {
+#ifdef AMT_HEX_X64
+            if (HasAVX2())
+                return EncodeHexSpacedAVX2;
+            if (HasSSSE3())
+                return EncodeHexSpacedSSSE3;
+#endif
+            return EncodeHexSpacedScalar;
+        }
+
+        using DecodeBlocksFunc = size_t (*)(const char*, size_t, uint8_t*);
+
+        static DecodeBlocksFunc GetBlockDecoder()
+        {
+#ifdef AMT_HEX_X64
+            if (HasAVX2())
+                return DecodeHexBlocksAVX2;
+            if (HasSSSE3())
+                return DecodeHexBlocksSSSE3;
+#endif
+            return nullptr;
+        }
+
+        static DecodeBlocksFunc GetPairDecoder()
+        {
+#ifdef AMT_HEX_X64
+            if (HasSSSE3())
+                return DecodeHexPairsSSSE3;
+#endif
+            return nullptr;
+        }
+
+        void EncodeHex(const uint8_t* data, size_t size, char* out)
+        {
+#ifdef AMT_HEX_X64
+            EncodeHexSSE2(data, size, out); // always there on x64
+#else
+            EncodeHexScalar(data, size, out);
+#endif
+        }
+
+        void EncodeHexSpaced(const uint8_t* data, size_t size, char* out)
+        {
+            static const EncodeFunc encode = GetSpacedEncoder();
+            encode(data, size, out);
+        }
+
+        std::string ToHex(const uint8_t* data, size_t size)
+        {
+            std::string s(size * 2, '\0');
+            EncodeHex(data, size, s.data());
+            return s;
+        }
+
+        std::string ToHexSpaced(const uint8_t* data, size_t size)
+        {
+            if (size == 0)
+                return {};
+
+            std::string s(size * 3, '\0');
+            EncodeHexSpaced(data, size, s.data());
+            s.pop_back();
+            return s;
+        }
+
+        bool DecodeHexSpaced(const char* text, size_t size, uint8_t* out, size_t& outSize, size_t& errorPos)
+        {
+            outSize = 0;
+            if (size == 0)
+                return true;
+
+            // The vector kernels take blocks of the canonical "hh hh " form and stop at the
+            // first other block. The scalar parser finishes up from there, accepting any
+            // spacing, and finds the exact position of bad text.
+            static const DecodeBlocksFunc decodeBlocks = GetBlockDecoder();
+            if (decodeBlocks)
+                outSize = decodeBlocks(text, size, out);
+
+            return DecodeHexSpacedScalar(text, size, outSize * 3, out, outSize, errorPos);
+        }
+
+        bool DecodeHex(const char* text, size_t size, uint8_t* out, size_t& errorPos)
+        {
+            static const DecodeBlocksFunc decodePairs = GetPairDecoder();
+            size_t done = decodePairs ? decodePairs(text, size, out) : 0;
+            return DecodeHexScalar(text, size, done * 2, out, errorPos);
+        }
+    } // namespace HexUtils
+} // namespace AMT
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace AMT
+{
+    namespace HexUtils
+    {
+        // Writes the 2 * size lowercase hex digits of data to out.
+        void EncodeHex(const uint8_t* data, size_t size, char* out);
+
+        // Writes data as space separated digit pairs ("0a ff 12") to out. Every pair is
+        // followed by a space, so out needs room for 3 * size chars.
+        void EncodeHexSpaced(const uint8_t* data, size_t size, char* out);
+
+        // data as lowercase hex digits, two per byte
+        std::string ToHex(const uint8_t* data, size_t size);
+
+        // data as space separated digit pairs, without the trailing space
+        std::string ToHexSpaced(const uint8_t* data, size_t size);
+
+        // Parses unseparated digit pairs ("0aFF12") into out, which needs room for size / 2
+        // bytes. Returns false if text isn't in that form, with errorPos set to the first
+        // offending char (size if it ends early).
+        bool DecodeHex(const char* text, size_t size, uint8_t* out, size_t& errorPos);
+
+        // Parses whitespace separated bytes of one or two digits ("0a FF 12", " a\n5f ") into
+        // out, which needs room for (size + 1) / 2 bytes. Returns false if text isn't in that
+        // form, with errorPos set to the first offending char.
+        bool DecodeHexSpaced(const char* text, size_t size, uint8_t* out, size_t& outSize, size_t& errorPos);
+    } // namespace HexUtils
+} // namespace AMT
@@ -2,6 +2,9 @@
 
 #include <iostream>
 #include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
 
 namespace AMT 
 {
@@ -64,5 +67,128 @@ namespace AMT
             in += sizeof (T);
             return data;
         }
+
+        // Loads and stores at any alignment, for decoding packed records in place
+        template <typename T>
+        T LoadUnaligned(const uint8_t *in)
+        {
+            T data;
+            memcpy(&data, in, sizeof(T));
+            return data;
+        }
+
+        template <typename T>
+        void StoreUnaligned(uint8_t *out, const T &data)
+        {
+            memcpy(out, &data, sizeof(T));
+        }
+
+        // Read everything from the current position to the end of the stream
+        inline std::vector<uint8_t> ReadRemaining(std::istream &in)
+        {
+            auto start = in.tellg();
+            in.seekg(0, std::ios::end);
+            auto size = in.tellg() - start;
+            in.seekg(start);
+
+            std::vector<uint8_t> buffer(static_cast<size_t>(size));
+            in.read(reinterpret_cast<char *>(buffer.data()), size);
+            return buffer;
+        }
+
+        // Bounds-checked cursor over an in-memory (or memory-mapped) buffer
+        class MemoryReader
+        {
+            const uint8_t *m_Data = nullptr;
+            size_t m_Size = 0;
+            size_t m_Pos = 0;
+
+        public:
+            MemoryReader(const uint8_t *data, size_t size) : m_Data(data), m_Size(size) {}
+
+            // Returns a pointer to the next size bytes and moves past them
+            const uint8_t *Skip(size_t size)
+            {
+                if (size > m_Size - m_Pos)
+                    throw std::runtime_error("Unexpected end of data");
+
+                const uint8_t *ptr = m_Data + m_Pos;
+                m_Pos += size;
+                return ptr;
+            }
+
+            void Read(void *data, size_t size)
+            {
+                memcpy(data, Skip(size), size);
+            }
+
+            template <typename T>
+            T Read()
+            {
+                T data;
+                memcpy(&data, Skip(sizeof(T)), sizeof(T));
+                return data;
+            }
+
+            const uint8_t *GetPtr() const { return m_Data + m_Pos; }
+            size_t GetRemaining() const { return m_Size - m_Pos; }
+        };
+
+        // Growable output buffer. Space for sizes and bitfields that are only known
+        // later is reserved and patched in memory, then the finished buffer is
+        // written out in one go.
+        class MemoryWriter
+        {
+            std::vector<uint8_t> m_Data;
+
+        public:
+            void Write(const void *data, size_t size)
+            {
+                const uint8_t *bytes = static_cast<const uint8_t *>(data);
+                m_Data.insert(m_Data.end(), bytes, bytes + size);
+            }
+
+            // Appends size zero bytes and returns their offset
+            size_t Reserve(size_t size)
+            {
+                size_t offset = m_Data.size();
+                m_Data.resize(offset + size);
+                return offset;
+            }
+
+            void Patch(size_t offset, const void *data, size_t size)
+            {
+                memcpy(m_Data.data() + offset, data, size);
+            }
+
+            template <typename T>
+            void Patch(size_t offset, const T &data)
+            {
+                Patch(offset, &data, sizeof(T));
+            }
+
+            void ReserveCapacity(size_t size) { m_Data.reserve(size); }
+
+            size_t GetSize() const { return m_Data.size(); }
+            const uint8_t *GetData() const { return m_Data.data(); }
+            uint8_t *GetData() { return m_Data.data(); }
+
+            void WriteTo(std::ostream &out) const
+            {
+                out.write(reinterpret_cast<const char *>(m_Data.data()), m_Data.size());
+            }
+        };
+
+        template <typename T>
+        void WriteData(MemoryWriter &out, const T &data, uint32_t size)
+        {
+            out.Write(&data, size);
+        }
+
+        template <typename T>
+        void WriteData(MemoryWriter &out, const T &data)
+        {
+            out.Write(&data, sizeof(T));
+        }
     }; // namespace IoUtils
 }; // namespace AMT
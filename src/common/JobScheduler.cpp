@@ -0,0 +1,205 @@
+#include "pch.h"
+#include "JobScheduler.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace AMT
+{
+    // Threads shared by every JobScheduler and ParallelFor call, started on first use and
+    // kept for the life of the process. The thread that runs a task works on it too and
+    // only waits for workers that are already busy with it, so a task started from a
+    // worker (e.g. a file job decoding its objects) can't deadlock or add threads.
+    class WorkerPool
+    {
+    public:
+        static WorkerPool& Instance()
+        {
+            static WorkerPool pool;
+            return pool;
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Stop = true;
+            }
+            m_Wake.notify_all();
+            for (auto& t : m_Threads)
+            {
+                t.join();
+            }
+        }
+
+        // Call func(i) for every i in [0, count) on up to numThreads threads, the calling
+        // one included. Indices are handed out in order. The first exception thrown stops
+        // the indices not yet started and is rethrown here.
+        void Run(size_t count, size_t numThreads, const std::function<void(size_t)>& func)
+        {
+            if (count == 0)
+                return;
+
+            auto task = std::make_shared<Task>();
+            task->func = &func;
+            task->count = count;
+
+            size_t numHelpers = std::min<size_t>(numThreads, count);
+            numHelpers = numHelpers > 0 ? numHelpers - 1 : 0;
+            if (numHelpers > 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    while (m_Threads.size() < numHelpers)
+                    {
+                        m_Threads.emplace_back([this] { WorkerLoop(); });
+                    }
+                    for (size_t i = 0; i < numHelpers; i++)
+                    {
+                        m_Queue.push_back(task);
+                    }
+                }
+                m_Wake.notify_all();
+            }
+
+            task->Work();
+
+            // Every index has been handed out. Helpers still queued will find none left,
+            // so only the ones working on an index are waited for.
+            {
+                std::unique_lock<std::mutex> lock(task->mutex);
+                task->finished.wait(lock, [&] { return task->active == 0; });
+            }
+
+            if (task->error)
+                std::rethrow_exception(task->error);
+        }
+
+    private:
+        struct Task
+        {
+            const std::function<void(size_t)>* func = nullptr;
+            size_t count = 0;
+            std::atomic<size_t> next = 0;
+            std::atomic<uint32_t> active = 0;   // helpers inside Work
+            std::mutex mutex;
+            std::condition_variable finished;
+            std::exception_ptr error;
+
+            void Work()
+            {
+                for (size_t i = next++; i < count; i = next++)
+                {
+                    try
+                    {
+                        (*func)(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!error)
+                            error = std::current_exception();
+                        next = count;
+                    }
+                }
+            }
+        };
+
+        void WorkerLoop()
+        {
+            for (;;)
+            {
+                std::shared_ptr<Task> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_Mutex);
+                    m_Wake.wait(lock, [&] { return m_Stop || !m_Queue.empty(); });
+                    if (m_Queue.empty())
+                        return;
+                    task = std::move(m_Queue.front());
+                    m_Queue.pop_front();
+                }
+
+                // Counted before taking an index, so the owner can't see the indices used up
+                // while this one is still running
+                task->active++;
+                task->Work();
+                if (--task->active == 0)
+                {
+                    std::lock_guard<std::mutex> lock(task->mutex);
+                    task->finished.notify_all();
+                }
+            }
+        }
+
+        std::mutex m_Mutex;
+        std::condition_variable m_Wake;
+        std::deque<std::shared_ptr<Task>> m_Queue;
+        std::vector<std::thread> m_Threads;
+        bool m_Stop = false;
+    };
+
+    JobScheduler::JobScheduler(uint32_t numWorkers)
+    {
+        m_NumWorkers = numWorkers > 0 ? numWorkers : GetDefaultWorkerCount();
+    }
+
+    uint32_t JobScheduler::GetDefaultWorkerCount()
+    {
+        uint32_t count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+
+    void JobScheduler::AddJob(uint64_t cost, std::function<void()> job)
+    {
+        m_Jobs.push_back({cost, std::move(job)});
+    }
+
+    void JobScheduler::Run()
+    {
+        // Largest first, so the wall time is bounded by the biggest job
+        std::stable_sort(m_Jobs.begin(), m_Jobs.end(), [](const Job& a, const Job& b) { return a.cost > b.cost; });
+
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        // A failing job doesn't stop the others from running
+        WorkerPool::Instance().Run(m_Jobs.size(), m_NumWorkers, [&](size_t i)
+        {
+            try
+            {
+                m_Jobs[i].func();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        });
+        m_Jobs.clear();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void JobScheduler::ParallelFor(size_t count, uint32_t numWorkers, const std::function<void(size_t)>& func, size_t grainSize)
+    {
+        if (count == 0)
+            return;
+
+        grainSize = std::max<size_t>(grainSize, 1);
+        size_t numBlocks = (count + grainSize - 1) / grainSize;
+
+        WorkerPool::Instance().Run(numBlocks, numWorkers > 0 ? numWorkers : GetDefaultWorkerCount(), [&](size_t block)
+        {
+            size_t end = std::min<size_t>(count, (block + 1) * grainSize);
+            for (size_t i = block * grainSize; i < end; i++)
+            {
+                func(i);
+            }
+        });
+    }
+} // namespace AMT
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace AMT
+{
+    class JobScheduler
+    {
+    public:
+        // numWorkers == 0 picks the hardware concurrency
+        JobScheduler(uint32_t numWorkers = 0);
+
+        // Queue a job. Jobs with a higher cost are started first.
+        void AddJob(uint64_t cost, std::function<void()> job);
+
+        // Run all queued jobs on up to GetNumWorkers() threads, this one included, and block
+        // until they have finished. The first exception thrown by a job is rethrown here.
+        void Run();
+
+        uint32_t GetNumWorkers() const { return m_NumWorkers; }
+
+        static uint32_t GetDefaultWorkerCount();
+
+        // Call func(i) for every i in [0, count) on up to numWorkers threads, this one included.
+        // Indices are handed out in blocks of grainSize. The threads are shared with every
+        // other job and ParallelFor, so calling this from a job doesn't add any.
+        static void ParallelFor(size_t count, uint32_t numWorkers, const std::function<void(size_t)>& func, size_t grainSize = 64);
+
+    private:
+        struct Job
+        {
+            uint64_t cost;
+            std::function<void()> func;
+        };
+
+        uint32_t m_NumWorkers = 1;
+        std::vector<Job> m_Jobs;
+    };
+} // namespace AMT
@@ -0,0 +1,141 @@
+#include "pch.h"
+#include "JsonWriter.h"
+#include <charconv>
+#include <cmath>
+
+namespace AMT
+{
+    JsonWriter::JsonWriter(std::ostream& out, uint32_t indent) : m_Out(out), m_Indent(indent)
+    {
+        m_Buffer.reserve(BufferSize + 1024);
+    }
+
+    JsonWriter::~JsonWriter()
+    {
+        Flush();
+    }
+
+    void JsonWriter::Flush()
+    {
+        m_Out.write(m_Buffer.data(), static_cast<std::streamsize>(m_Buffer.size()));
+        m_Buffer.clear();
+    }
+
+    void JsonWriter::NewLine()
+    {
+        m_Buffer += '\n';
+        m_Buffer.append(m_Empty.size() * m_Indent, ' ');
+    }
+
+    // Array elements go on a line of their own, object values follow their key
+    void JsonWriter::BeginValue()
+    {
+        if (m_AfterKey)
+        {
+            m_AfterKey = false;
+            return;
+        }
+
+        if (!m_Empty.empty())
+        {
+            if (!m_Empty.back())
+                m_Buffer += ',';
+            m_Empty.back() = false;
+            NewLine();
+        }
+    }
+
+    void JsonWriter::BeginContainer(char open)
+    {
+        BeginValue();
+        m_Buffer += open;
+        m_Empty.push_back(true);
+    }
+
+    void JsonWriter::EndContainer(char close)
+    {
+        bool empty = m_Empty.back();
+        m_Empty.pop_back();
+        if (!empty)
+            NewLine();
+        Append(&close, 1);
+    }
+
+    void JsonWriter::BeginObject() { BeginContainer('{'); }
+    void JsonWriter::EndObject() { EndContainer('}'); }
+    void JsonWriter::BeginArray() { BeginContainer('['); }
+    void JsonWriter::EndArray() { EndContainer(']'); }
+
+    void JsonWriter::Key(std::string_view key)
+    {
+        BeginValue();
+        WriteString(key);
+        m_Buffer += ": ";
+        m_AfterKey = true;
+    }
+
+    void JsonWriter::Null()
+    {
+        BeginValue();
+        Append("null", 4);
+    }
+
+    void JsonWriter::UInt(uint64_t value)
+    {
+        BeginValue();
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        Append(buf, res.ptr - buf);
+    }
+
+    void JsonWriter::Int(int64_t value)
+    {
+        BeginValue();
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        Append(buf, res.ptr - buf);
+    }
+
+    void JsonWriter::Double(double value)
+    {
+        BeginValue();
+        if (!std::isfinite(value))
+        {
+            Append("null", 4);
+            return;
+        }
+
+        // The library's own shortest round trip formatting, so numbers match dump()
+        char buf[64];
+        char* end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), value);
+        Append(buf, end - buf);
+    }
+
+    void JsonWriter::String(std::string_view value)
+    {
+        BeginValue();
+        WriteString(value);
+        if (m_Buffer.size() >= BufferSize)
+            Flush();
+    }
+
+    void JsonWriter::WriteString(std::string_view value)
+    {
+        // Names and hex data are plain ASCII and are copied as they are. Anything that
+        // needs escaping or UTF-8 checks goes through the library, which also raises
+        // the same error dump() would.
+        for (char c : value)
+        {
+            auto u = static_cast<unsigned char>(c);
+            if (u < 0x20 || u >= 0x80 || c == '"' || c == '\\')
+            {
+                m_Buffer += nlohmann::json(std::string(value)).dump();
+                return;
+            }
+        }
+
+        m_Buffer += '"';
+        m_Buffer.append(value);
+        m_Buffer += '"';
+    }
+} // namespace AMT
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AMT
+{
+    // Writes JSON tokens to a stream as they come, formatted exactly like
+    // ordered_json::dump(indent). Output is buffered and flushed in blocks, so memory
+    // use doesn't depend on the size of the document.
+    class JsonWriter
+    {
+    public:
+        explicit JsonWriter(std::ostream& out, uint32_t indent = 4);
+        ~JsonWriter();
+
+        JsonWriter(const JsonWriter&) = delete;
+        JsonWriter& operator=(const JsonWriter&) = delete;
+
+        void BeginObject();
+        void EndObject();
+        void BeginArray();
+        void EndArray();
+
+        // Name of the next value, inside an object
+        void Key(std::string_view key);
+
+        void Null();
+        void UInt(uint64_t value);
+        void Int(int64_t value);
+        void Double(double value);
+        void String(std::string_view value);
+
+        void Flush();
+
+    private:
+        void BeginValue();
+        void BeginContainer(char open);
+        void EndContainer(char close);
+        void NewLine();
+        void WriteString(std::string_view value);
+
+        void Append(const char* data, size_t size)
+        {
+            m_Buffer.append(data, size);
+            if (m_Buffer.size() >= BufferSize)
+                Flush();
+        }
+
+        static constexpr size_t BufferSize = 64 * 1024;
+
+        std::ostream& m_Out;
+        std::string m_Buffer;
+        uint32_t m_Indent;
+        std::vector<bool> m_Empty; // per open container, nothing written to it yet
+        bool m_AfterKey = false;
+    };
+} // namespace AMT
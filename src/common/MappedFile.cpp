@@ -0,0 +1,111 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AMT
+{
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        m_File = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            Close();
+            return false;
+        }
+
+        m_Size = static_cast<size_t>(size.QuadPart);
+        if (m_Size == 0)
+            return true; // nothing to map
+
+        m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_Mapping)
+        {
+            Close();
+            return false;
+        }
+
+        m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_Data)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_Mapping)
+            CloseHandle(m_Mapping);
+        if (m_File)
+            CloseHandle(m_File);
+
+        m_Data = nullptr;
+        m_Mapping = nullptr;
+        m_File = nullptr;
+        m_Size = 0;
+    }
+#else
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+
+        m_File = open(path.c_str(), O_RDONLY);
+        if (m_File < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(m_File, &st) != 0)
+        {
+            Close();
+            return false;
+        }
+
+        m_Size = static_cast<size_t>(st.st_size);
+        if (m_Size == 0)
+            return true; // nothing to map
+
+        void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+        if (data == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+        m_Data = static_cast<const uint8_t*>(data);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            munmap(const_cast<uint8_t*>(m_Data), m_Size);
+        if (m_File >= 0)
+            close(m_File);
+
+        m_Data = nullptr;
+        m_File = -1;
+        m_Size = 0;
+    }
+#endif
+} // namespace AMT
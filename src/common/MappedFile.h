@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace AMT
+{
+    // Read-only memory mapping of a whole file
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Returns false if the file can't be opened or mapped
+        bool Open(const std::string& path);
+        void Close();
+
+        const uint8_t* GetData() const { return m_Data; }
+        size_t GetSize() const { return m_Size; }
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+
+#ifdef _WIN32
+        void* m_File = nullptr;
+        void* m_Mapping = nullptr;
+#else
+        int m_File = -1;
+#endif
+    };
+} // namespace AMT
@@ -1,187 +1,239 @@
 #include "pch.h"
 #include "MetadataFile.h"
 #include "HashManager.h"
+#include "JobScheduler.h"
+#include "Stats.h"
+#include <functional>
+#include <unordered_set>
 
 namespace AMT
 {
-    void MetadataFile::ReadObjectsData(std::istream& in)
+    const uint8_t* MetadataFile::ReadObjectsData(IoUtils::MemoryReader& in, uint32_t& dataSize)
     {
-        uint32_t dataSize = IoUtils::ReadData<uint32_t>(in);
-        m_RawData = std::make_unique<uint8_t[]>(dataSize);
-        IoUtils::ReadData(in, m_RawData.get(), dataSize);
+        // The objects are decoded straight from the input buffer, no copy is made
+        dataSize = in.Read<uint32_t>();
+        return in.Skip(dataSize);
     }
 
-    void MetadataFile::ReadArchiveList(std::istream& in)
+    void MetadataFile::ReadArchiveList(IoUtils::MemoryReader& in)
     {
         const uint32_t SANE_SIZE = static_cast<uint32_t>(1e9);
 
-        uint32_t blockSize = IoUtils::ReadData<uint32_t>(in);
-        uint32_t numArchives = IoUtils::ReadData<uint32_t>(in);
+        uint32_t blockSize = in.Read<uint32_t>();
+        uint32_t numArchives = in.Read<uint32_t>();
 
         if (numArchives == 0)
             return;
 
-        if (blockSize > SANE_SIZE)
+        if (blockSize > SANE_SIZE || blockSize < 4 + (static_cast<uint64_t>(numArchives) * 4))
             throw std::runtime_error("Sanity check failed on reading archive lists");
 
         uint32_t namesSize = blockSize - 4 - (numArchives * 4);
-        auto offsets = std::make_unique<uint32_t[]>(numArchives);
-        auto strs = std::make_unique<char[]>(namesSize);
-
-        IoUtils::ReadData(in, offsets.get(), numArchives * 4);
-        IoUtils::ReadData(in, strs.get(), namesSize);
+        const uint8_t* offsets = in.Skip(numArchives * 4);
+        const char* strs = reinterpret_cast<const char*>(in.Skip(namesSize));
 
         for (uint32_t i = 0; i < numArchives; i++)
         {
-            std::string archive(strs.get() + offsets[i]);
+            uint32_t offset;
+            memcpy(&offset, offsets + i * 4, 4);
+
+            const char* end = offset < namesSize ? static_cast<const char*>(memchr(strs + offset, 0, namesSize - offset)) : nullptr;
+            if (!end)
+                throw std::runtime_error("Archive name out of bounds");
+
+            std::string archive(strs + offset, end);
             std::replace(archive.begin(), archive.end(), '\\', '/');
             HashManager::Instance()->AddHash(archive);
         }
     }
 
-    void MetadataFile::ReadObjectsMetadata(std::istream& in)
+    std::vector<MetadataFile::ObjectEntry> MetadataFile::ReadObjectTable(IoUtils::MemoryReader& in)
     {
-        uint32_t numObjects = IoUtils::ReadData<uint32_t>(in);
-        uint32_t sizeOfNames = IoUtils::ReadData<uint32_t>(in);
+        uint32_t numObjects = in.Read<uint32_t>();
+        uint32_t sizeOfNames = in.Read<uint32_t>();
+
+        std::vector<ObjectEntry> entries;
+        entries.reserve(std::min<size_t>(numObjects, in.GetRemaining() / 9));
 
         for (uint32_t i = 0; i < numObjects; i++)
         {
-            uint8_t nameLen = IoUtils::ReadData<uint8_t>(in);
-            auto nameRaw = std::make_unique<char[]>(nameLen);
-            IoUtils::ReadData(in, nameRaw.get(), nameLen);
+            uint8_t nameLen = in.Read<uint8_t>();
 
-            uint32_t offset = IoUtils::ReadData<uint32_t>(in);
-            uint32_t size = IoUtils::ReadData<uint32_t>(in);
+            ObjectEntry entry;
+            entry.name.assign(reinterpret_cast<const char*>(in.Skip(nameLen)), nameLen);
+            entry.offset = in.Read<uint32_t>();
+            entry.size = in.Read<uint32_t>();
 
-            std::string name(nameRaw.get(), nameLen);
-            HashManager::Instance()->AddHash(name);
+            HashManager::Instance()->AddHash(entry.name);
+            entries.push_back(std::move(entry));
+        }
+        return entries;
+    }
 
-            MetadataObject obj(m_FileDef);
-            obj.SetName(name);
-            obj.Read(&(m_RawData.get()[offset]), size, m_DebugMode);
+    void MetadataFile::ReadObjectsMetadata(IoUtils::MemoryReader& in, const uint8_t* objectsData, uint32_t dataSize)
+    {
+        // The whole table is read (and its names registered) before any object is
+        // decoded, so the objects only read from the hash table and can be decoded
+        // independently, each into its own slot.
+        std::vector<ObjectEntry> entries = ReadObjectTable(in);
 
-            m_Objects.push_back(std::move(obj));
+        for (const auto& entry : entries)
+        {
+            if (entry.offset > dataSize || entry.size > dataSize - entry.offset)
+                throw std::runtime_error("Object " + entry.name + " is out of bounds");
         }
+
+        size_t first = m_Objects.size();
+        m_Objects.resize(first + entries.size(), MetadataObject(m_FileDef));
+        Stats::AddObjects(entries.size());
+
+        // Objects are decoded in blocks, each into an arena of its own, so the workers
+        // never share an allocator
+        const size_t blockSize = 64;
+        size_t numBlocks = (entries.size() + blockSize - 1) / blockSize;
+        size_t firstArena = m_Arenas.size();
+        m_Arenas.resize(firstArena + numBlocks);
+
+        JobScheduler::ParallelFor(numBlocks, m_NumWorkers, [&](size_t block)
+        {
+            Arena& arena = m_Arenas[firstArena + block];
+            size_t end = std::min<size_t>((block + 1) * blockSize, entries.size());
+            for (size_t i = block * blockSize; i < end; i++)
+            {
+                MetadataObject& obj = m_Objects[first + i];
+                obj.SetName(entries[i].name);
+                obj.Read(objectsData + entries[i].offset, entries[i].size, arena, m_DebugMode);
+            }
+        }, 1);
     }
 
-    void MetadataFile::Read(std::istream& in)
+    void MetadataFile::Read(const uint8_t* data, size_t size)
     {
-        uint32_t suffix = IoUtils::ReadData<uint32_t>(in);
+        IoUtils::MemoryReader in(data, size);
+
+        uint32_t suffix = in.Read<uint32_t>();
         if (suffix != m_FileDef->suffix)
         {
             std::cout << "Suffix mismatch" << std::endl;
         }
 
-        ReadObjectsData(in);
+        uint32_t dataSize;
+        const uint8_t* objectsData = ReadObjectsData(in, dataSize);
         ReadArchiveList(in);
-        ReadObjectsMetadata(in);
+        ReadObjectsMetadata(in, objectsData, dataSize);
     }
 
-    void MetadataFile::WriteObjectsData(std::ostream& out)
+    void MetadataFile::Read(std::istream& in)
     {
-        auto pos = out.tellp();
-        out.seekp(4, std::ios_base::cur); // skip data size
+        std::vector<uint8_t> buffer = IoUtils::ReadRemaining(in);
+        Read(buffer.data(), buffer.size());
+    }
 
-        uint32_t nameOffset = 0;
-        for (auto& obj : m_Objects)
-        {
-            uint8_t zero = 0;
-            IoUtils::WriteData(out, zero); // null padding byte
+    void MetadataFile::ReadNames(const uint8_t* data, size_t size)
+    {
+        IoUtils::MemoryReader in(data, size);
+        in.Read<uint32_t>(); // suffix
 
-            m_InternalObjectOffsets.push_back(static_cast<uint32_t>(out.tellp()));
-            obj.Write(out, nameOffset);
+        uint32_t dataSize;
+        ReadObjectsData(in, dataSize);
+        ReadArchiveList(in);
+        ReadObjectTable(in);
+    }
 
-            nameOffset += static_cast<uint32_t>(obj.GetName().size() + 1);
-        }
+    size_t MetadataFile::BeginObjectsData(IoUtils::MemoryWriter& out)
+    {
+        m_Layout = {};
+        m_InternalObjectOffsets.clear();
+        m_ObjectSizes.clear();
+        m_ObjectNames.clear();
+        m_ObjectNamesSize = 0;
 
-        auto end = out.tellp();
-        out.seekp(pos);
-        IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(end - pos - 4));
-        out.seekp(end);
+        return out.Reserve(4); // data size
     }
 
-    nlohmann::fifo_map<std::string, int> MetadataFile::GenerateArchiveNames()
+    void MetadataFile::WriteObjectData(IoUtils::MemoryWriter& out, MetadataObject& obj)
     {
-        nlohmann::fifo_map<std::string, int> names;
+        uint8_t zero = 0;
+        IoUtils::WriteData(out, zero); // null padding byte
+
+        // Writing is also the layout pass: the one walk per object gives its size, its
+        // patch offsets and its archive names, nothing measures the object beforehand
+        size_t objStart = out.GetSize();
+        m_InternalObjectOffsets.push_back(static_cast<uint32_t>(objStart));
+        obj.Write(out, m_ObjectNamesSize, &m_Layout);
+        m_ObjectSizes.push_back(static_cast<uint32_t>(out.GetSize() - objStart));
+
+        m_ObjectNames.push_back(obj.GetName());
+        m_ObjectNamesSize += static_cast<uint32_t>(obj.GetName().size() + 1);
+    }
+
+    void MetadataFile::EndObjectsData(IoUtils::MemoryWriter& out, size_t pos)
+    {
+        out.Patch<uint32_t>(pos, static_cast<uint32_t>(out.GetSize() - pos - 4));
+    }
+
+    void MetadataFile::WriteObjectsData(IoUtils::MemoryWriter& out)
+    {
+        size_t pos = BeginObjectsData(out);
+
+        m_InternalObjectOffsets.reserve(m_Objects.size());
+        m_ObjectSizes.reserve(m_Objects.size());
+        m_ObjectNames.reserve(m_Objects.size());
         for (auto& obj : m_Objects)
         {
-            obj.GetArchiveNames(names);
+            WriteObjectData(out, obj);
         }
-        return names;
+
+        EndObjectsData(out, pos);
     }
 
-    void MetadataFile::WriteArchiveList(std::ostream& out)
+    void MetadataFile::WriteArchiveList(IoUtils::MemoryWriter& out)
     {
-        auto archiveNames = GenerateArchiveNames();
+        const auto& archiveNames = m_Layout.archiveNames;
 
-        auto blockStart = out.tellp();
-        out.seekp(8 + (archiveNames.size() * 4), std::ios_base::cur);
+        size_t blockStart = out.Reserve(8 + (archiveNames.size() * 4));
+        size_t strsStart = out.GetSize();
 
         std::vector<uint32_t> archiveOffsets;
-        auto strsStart = out.tellp();
-
-        for (const auto& [name, _] : archiveNames)
+        for (const auto& name : archiveNames)
         {
             std::string winName = name;
             std::replace(winName.begin(), winName.end(), '/', '\\');
 
-            archiveOffsets.push_back(static_cast<uint32_t>(out.tellp() - strsStart));
-            out.write(winName.c_str(), winName.size() + 1);
+            archiveOffsets.push_back(static_cast<uint32_t>(out.GetSize() - strsStart));
+            out.Write(winName.c_str(), winName.size() + 1);
         }
 
-        auto blockEnd = out.tellp();
-        out.seekp(blockStart);
-
-        IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(blockEnd - blockStart - 4));
-        IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(archiveNames.size()));
+        out.Patch<uint32_t>(blockStart, static_cast<uint32_t>(out.GetSize() - blockStart - 4));
+        out.Patch<uint32_t>(blockStart + 4, static_cast<uint32_t>(archiveNames.size()));
         if (!archiveOffsets.empty())
         {
-            IoUtils::WriteData<uint32_t>(out, archiveOffsets[0], static_cast<uint32_t>(4 * archiveOffsets.size()));
+            out.Patch(blockStart + 8, archiveOffsets.data(), 4 * archiveOffsets.size());
         }
-
-        out.seekp(blockEnd);
     }
 
-    void MetadataFile::WriteObjectsMetadata(std::ostream& out)
+    void MetadataFile::WriteObjectsMetadata(IoUtils::MemoryWriter& out)
     {
-        auto blockStart = out.tellp();
-        out.seekp(8, std::ios_base::cur);
+        size_t blockStart = out.Reserve(8);
 
-        uint32_t objectNamesCapacity = 0;
-        size_t index = 0;
-        for (auto& obj : m_Objects)
+        for (size_t index = 0; index < m_ObjectNames.size(); index++)
         {
-            IoUtils::WriteData<uint8_t>(out, static_cast<uint8_t>(obj.GetName().length()));
-            out.write(obj.GetName().c_str(), obj.GetName().length());
+            const std::string& name = m_ObjectNames[index];
+            IoUtils::WriteData<uint8_t>(out, static_cast<uint8_t>(name.length()));
+            out.Write(name.c_str(), name.length());
 
             IoUtils::WriteData<uint32_t>(out, m_InternalObjectOffsets[index] - 8);
-            IoUtils::WriteData(out, obj.GetSize());
-
-            objectNamesCapacity += static_cast<uint32_t>(obj.GetName().length() + 1);
-            index++;
+            IoUtils::WriteData<uint32_t>(out, m_ObjectSizes[index]);
         }
 
-        auto blockEnd = out.tellp();
-        out.seekp(blockStart);
-
-        IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(m_Objects.size()));
-        IoUtils::WriteData<uint32_t>(out, objectNamesCapacity);
-
-        out.seekp(blockEnd);
+        out.Patch<uint32_t>(blockStart, static_cast<uint32_t>(m_ObjectNames.size()));
+        out.Patch<uint32_t>(blockStart + 4, m_ObjectNamesSize);
     }
 
-    void MetadataFile::WriteObjectArchiveNamesOffsets(std::ostream& out)
+    void MetadataFile::WriteObjectArchiveNamesOffsets(IoUtils::MemoryWriter& out)
     {
-        std::vector<uint32_t> hashOffsets;
-        std::vector<uint32_t> archiveOffsets;
-
-        size_t index = 0;
-        for (auto& obj : m_Objects)
-        {
-            obj.GetArchiveOffsets(archiveOffsets, m_InternalObjectOffsets[index]);
-            obj.GetHashOffsets(hashOffsets, m_InternalObjectOffsets[index]);
-            index++;
-        }
+        const auto& hashOffsets = m_Layout.hashOffsets;
+        const auto& archiveOffsets = m_Layout.archiveOffsets;
 
         IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(hashOffsets.size()));
         if (!hashOffsets.empty())
@@ -195,8 +247,9 @@ namespace AMT
         }
     }
 
-    void MetadataFile::Write(std::ostream& out)
+    void MetadataFile::Write(IoUtils::MemoryWriter& out)
     {
+        // Offsets written into the file are relative to the start of the buffer
         IoUtils::WriteData<uint32_t>(out, m_FileDef->suffix);
         WriteObjectsData(out);
         WriteArchiveList(out);
@@ -204,6 +257,369 @@ namespace AMT
         WriteObjectArchiveNamesOffsets(out);
     }
 
+    void MetadataFile::Write(std::ostream& out)
+    {
+        IoUtils::MemoryWriter writer;
+        Write(writer);
+        writer.WriteTo(out);
+    }
+
+    // Runs func, naming the object in the message of anything it throws. Field errors
+    // only know the field, which doesn't say where in a file of thousands of objects it is.
+    template <typename Func>
+    static void WithObjectName(const std::string& name, Func&& func)
+    {
+        try
+        {
+            func();
+        }
+        catch (const std::exception& e)
+        {
+            throw std::runtime_error(std::string(e.what()) + " in object " + name);
+        }
+    }
+
+    // Takes the parser's events for a whole file and encodes every object as soon as it
+    // is complete. Only the current object is held, in an arena reset between objects.
+    class MetadataJsonLoader
+    {
+    public:
+        using ObjectCallback = std::function<void(MetadataObject&)>;
+
+        MetadataJsonLoader(const MetadataFileDef* fileDef, const ObjectCallback& onObject)
+            : m_FileDef(fileDef), m_OnObject(onObject), m_Builder(m_Arena) {}
+
+        bool null()
+        {
+            if (m_Capture) CaptureValue(nullptr);
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.Null(); });
+            else if (!Skipped()) Scalar(nullptr);
+            return true;
+        }
+
+        bool boolean(bool val)
+        {
+            if (m_Capture) CaptureValue(val);
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.Boolean(val); });
+            else if (!Skipped()) Scalar(nullptr);
+            return true;
+        }
+
+        bool number_integer(ordered_json::number_integer_t val)
+        {
+            if (m_Capture) CaptureValue(val);
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.Integer(val); });
+            else if (!Skipped()) Scalar(nullptr);
+            return true;
+        }
+
+        bool number_unsigned(ordered_json::number_unsigned_t val)
+        {
+            if (m_Capture) CaptureValue(val);
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.Unsigned(val); });
+            else if (!Skipped()) Scalar(nullptr);
+            return true;
+        }
+
+        bool number_float(ordered_json::number_float_t val, const std::string&)
+        {
+            if (m_Capture) CaptureValue(val);
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.Float(val); });
+            else if (!Skipped()) Scalar(nullptr);
+            return true;
+        }
+
+        bool string(std::string& val)
+        {
+            if (m_Capture) CaptureValue(val);
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.String(val); });
+            else if (!Skipped()) Scalar(&val);
+            return true;
+        }
+
+        bool binary(ordered_json::binary_t&)
+        {
+            return true; // not produced by the JSON parser
+        }
+
+        bool start_object(size_t)
+        {
+            if (m_Capture) m_Capture->StartObject();
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.StartObject(); });
+            else if (!StartSkipped()) StartObject();
+            return true;
+        }
+
+        bool key(std::string& val)
+        {
+            if (m_Capture) m_Capture->Key(val);
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.Key(val); });
+            else if (m_SkipDepth == 0) Key(val);
+            return true;
+        }
+
+        bool end_object()
+        {
+            if (m_Capture) EndCapture(m_Capture->End());
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.EndObject(); });
+            else if (m_SkipDepth > 0) m_SkipDepth--;
+            else EndObject();
+            return true;
+        }
+
+        bool start_array(size_t)
+        {
+            if (m_Capture) m_Capture->StartArray();
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.StartArray(); });
+            else if (!StartSkipped()) throw std::runtime_error("Unexpected array in " + Where());
+            return true;
+        }
+
+        bool end_array()
+        {
+            if (m_Capture) EndCapture(m_Capture->End());
+            else if (m_Builder.IsActive()) Build([&] { m_Builder.EndArray(); });
+            else m_SkipDepth--;
+            return true;
+        }
+
+        bool parse_error(size_t, const std::string&, const nlohmann::detail::exception& ex)
+        {
+            throw std::runtime_error(ex.what());
+        }
+
+    private:
+        // Builds a document from events, for a Metadata value that comes before the
+        // Type saying how to read it
+        class Capture
+        {
+            ordered_json& m_Root;
+            std::vector<ordered_json*> m_Stack;
+            std::string m_Key;
+
+            ordered_json* Add(ordered_json val)
+            {
+                if (m_Stack.empty())
+                {
+                    m_Root = std::move(val);
+                    return &m_Root;
+                }
+
+                ordered_json& parent = *m_Stack.back();
+                if (parent.is_array())
+                {
+                    parent.push_back(std::move(val));
+                    return &parent.back();
+                }
+                ordered_json& member = parent[m_Key];
+                member = std::move(val);
+                return &member;
+            }
+
+        public:
+            explicit Capture(ordered_json& root) : m_Root(root) {}
+
+            // Returns true once the whole value has been captured
+            template <typename T>
+            bool Value(T&& val)
+            {
+                Add(ordered_json(std::forward<T>(val)));
+                return m_Stack.empty();
+            }
+
+            void StartObject() { m_Stack.push_back(Add(ordered_json::object())); }
+            void StartArray() { m_Stack.push_back(Add(ordered_json::array())); }
+            void Key(const std::string& key) { m_Key = key; }
+
+            bool End()
+            {
+                m_Stack.pop_back();
+                return m_Stack.empty();
+            }
+        };
+
+        template <typename T>
+        void CaptureValue(T&& val)
+        {
+            EndCapture(m_Capture->Value(std::forward<T>(val)));
+        }
+
+        void EndCapture(bool done)
+        {
+            if (done)
+                m_Capture.reset();
+        }
+
+        template <typename Func>
+        void Build(Func&& func)
+        {
+            WithObjectName(m_Object.GetName(), func);
+        }
+
+        // At level 1 the value of entry m_Key is being parsed, m_Object is still the one
+        // before it until the entry turns out to be an object
+        std::string Where() const
+        {
+            if (m_Level == 0)
+                return "file";
+            return "object " + (m_Level == 1 ? m_Key : m_Object.GetName());
+        }
+
+        // A value of a key that isn't read, at the object level
+        bool Skipped()
+        {
+            if (m_SkipDepth > 0)
+                return true;
+            if (!m_SkipNext)
+                return false;
+            m_SkipNext = false;
+            return true;
+        }
+
+        bool StartSkipped()
+        {
+            if (m_SkipDepth > 0 || m_SkipNext)
+            {
+                m_SkipNext = false;
+                m_SkipDepth++;
+                return true;
+            }
+            return false;
+        }
+
+        void Scalar(const std::string* str)
+        {
+            if (m_Level == 0 && !str)
+                return; // a file without objects is written as null
+
+            if (m_Level == 2 && m_ReadType)
+            {
+                m_ReadType = false;
+                if (!str)
+                    throw std::runtime_error("Type of object " + m_Object.GetName() + " must be a string");
+                m_Object.SetTypeName(*str);
+                m_HasType = true;
+                return;
+            }
+
+            throw std::runtime_error("Unexpected value in " + Where());
+        }
+
+        void StartObject()
+        {
+            switch (m_Level)
+            {
+                case 0:
+                    break;
+                case 1:
+                {
+                    m_Object = MetadataObject(m_FileDef);
+                    m_Object.SetName(m_Key);
+                    m_Builder.InitFields(m_FileDef->headerProgram, m_Object.GetHeaderValues());
+                    m_HasType = false;
+                    m_HasMetadata = false;
+                    m_Metadata = nullptr;
+                    break;
+                }
+                default:
+                    throw std::runtime_error("Unexpected object in " + Where());
+            }
+            m_Level++;
+        }
+
+        void Key(const std::string& key)
+        {
+            if (m_Level == 1)
+            {
+                m_Key = key;
+                return;
+            }
+
+            if (key == "Type")
+            {
+                m_ReadType = true;
+            }
+            else if (key == "Metadata")
+            {
+                m_HasMetadata = true;
+                const MetadataTypeDef* typeDef = m_HasType ? m_Object.GetTypeDef() : nullptr;
+                if (typeDef)
+                    m_Builder.BeginFields(typeDef->program, m_Object.GetTypeValues());
+                else
+                    m_Capture = std::make_unique<Capture>(m_Metadata);
+            }
+            else if (!m_Builder.BeginField(m_FileDef->headerProgram, m_Object.GetHeaderValues(), key))
+            {
+                m_SkipNext = true;
+            }
+        }
+
+        void EndObject()
+        {
+            m_Level--;
+            if (m_Level != 1)
+                return;
+
+            if (!m_HasType)
+                throw std::runtime_error("Object " + m_Object.GetName() + " has no Type");
+
+            // Metadata seen before the type was known is converted now
+            const MetadataTypeDef* typeDef = m_Object.GetTypeDef();
+            if (typeDef)
+            {
+                if (!m_HasMetadata)
+                    throw std::runtime_error("Object " + m_Object.GetName() + " has no Metadata");
+                if (!m_Object.GetTypeValues().IsPresent())
+                    Build([&] { FieldIO::FromJson(typeDef->program, m_Metadata, m_Arena, m_Object.GetTypeValues()); });
+            }
+
+            m_OnObject(m_Object);
+            m_Arena.Reset();
+        }
+
+        const MetadataFileDef* m_FileDef;
+        ObjectCallback m_OnObject;
+        Arena m_Arena;
+        FieldIO::FieldBuilder m_Builder;
+
+        uint32_t m_Level = 0;       // 1 in the file's object, 2 in an object's
+        std::string m_Key;
+        MetadataObject m_Object;
+        bool m_ReadType = false;
+        bool m_HasType = false;
+        bool m_HasMetadata = false;
+        ordered_json m_Metadata;
+        std::unique_ptr<Capture> m_Capture;
+        bool m_SkipNext = false;
+        uint32_t m_SkipDepth = 0;
+    };
+
+    void MetadataFile::WriteFromJson(const char* json, size_t size, IoUtils::MemoryWriter& out)
+    {
+        IoUtils::WriteData<uint32_t>(out, m_FileDef->suffix);
+        size_t pos = BeginObjectsData(out);
+
+        // Objects can't be replaced once written, so a name may only be used once
+        std::unordered_set<std::string> names;
+        MetadataJsonLoader loader(m_FileDef, [&](MetadataObject& obj)
+        {
+            if (!names.insert(obj.GetName()).second)
+                throw std::runtime_error("Object " + obj.GetName() + " is defined more than once");
+
+            // Encoding is timed apart from the parsing around it
+            Stats::ScopedPhase phase(Stats::Phase::Write);
+            WithObjectName(obj.GetName(), [&] { WriteObjectData(out, obj); });
+            Stats::AddObjects(1);
+        });
+        ordered_json::sax_parse(json, json + size, &loader, ordered_json::input_format_t::json, false);
+
+        Stats::ScopedPhase phase(Stats::Phase::Write);
+        EndObjectsData(out, pos);
+        WriteArchiveList(out);
+        WriteObjectsMetadata(out);
+        WriteObjectArchiveNamesOffsets(out);
+    }
+
     void MetadataFile::ToJson(ordered_json& j) const
     {
         for (const auto& obj : m_Objects)
@@ -214,14 +630,48 @@ namespace AMT
         }
     }
 
+    void MetadataFile::WriteJson(std::ostream& out) const
+    {
+        JsonWriter writer(out);
+        if (m_Objects.empty())
+        {
+            writer.Null();
+            return;
+        }
+
+        // An object name used twice is written at its first position with the
+        // value of its last object, like assigning them to ordered_json in turn
+        std::unordered_map<std::string_view, size_t> last;
+        last.reserve(m_Objects.size());
+        for (size_t i = 0; i < m_Objects.size(); i++)
+        {
+            last[m_Objects[i].GetName()] = i;
+        }
+
+        writer.BeginObject();
+        for (const auto& obj : m_Objects)
+        {
+            auto it = last.find(obj.GetName());
+            if (it->second == SIZE_MAX)
+                continue;
+
+            writer.Key(obj.GetName());
+            m_Objects[it->second].WriteJson(writer);
+            it->second = SIZE_MAX;
+        }
+        writer.EndObject();
+    }
+
     void MetadataFile::FromJson(const ordered_json& j)
     {
+        Arena& arena = m_Arenas.emplace_back();
         for (const auto& [key, value] : j.items())
         {
             MetadataObject obj(m_FileDef);
-            obj.FromJson(value);
+            WithObjectName(key, [&] { obj.FromJson(value, arena); });
             obj.SetName(key);
             m_Objects.push_back(std::move(obj));
         }
+        Stats::AddObjects(j.size());
     }
 } // namespace AMT
@@ -15,28 +15,65 @@ namespace AMT
         MetadataFile() = default;
         MetadataFile(const MetadataFileDef* fileDef, bool debugMode = false) : m_FileDef(fileDef), m_DebugMode(debugMode) {}
 
+        // Objects are decoded on up to numWorkers threads (0 = one per core)
+        void SetNumWorkers(uint32_t numWorkers) { m_NumWorkers = numWorkers; }
+
+        size_t GetNumObjects() const { return m_Objects.size(); }
+
+        // Parse a whole file held in memory (e.g. a memory mapping). The buffer only
+        // has to stay valid for the duration of the call.
+        void Read(const uint8_t* data, size_t size);
         void Read(std::istream& in);
+
+        // Register the archive and object names of a file without decoding its objects
+        void ReadNames(const uint8_t* data, size_t size);
+
+        // The whole file is built in memory and written to out in one call
+        void Write(IoUtils::MemoryWriter& out);
         void Write(std::ostream& out);
 
         void ToJson(ordered_json& j) const;
+
+        // Writes the JSON form of the file to out as it goes, the same text as
+        // ToJson followed by dump(4)
+        void WriteJson(std::ostream& out) const;
         void FromJson(const ordered_json& j);
 
+        // Encode the JSON form of a file (json, not null terminated) straight to binary.
+        // Objects are parsed and written one at a time, neither a document nor the
+        // objects are kept.
+        void WriteFromJson(const char* json, size_t size, IoUtils::MemoryWriter& out);
+
     private:
-        void ReadObjectsData(std::istream& in);
-        void ReadArchiveList(std::istream& in);
-        void ReadObjectsMetadata(std::istream& in);
+        struct ObjectEntry
+        {
+            std::string name;
+            uint32_t offset;
+            uint32_t size;
+        };
 
-        void WriteObjectsData(std::ostream& out);
-        void WriteArchiveList(std::ostream& out);
-        void WriteObjectsMetadata(std::ostream& out);
-        void WriteObjectArchiveNamesOffsets(std::ostream& out);
+        const uint8_t* ReadObjectsData(IoUtils::MemoryReader& in, uint32_t& dataSize);
+        void ReadArchiveList(IoUtils::MemoryReader& in);
+        void ReadObjectsMetadata(IoUtils::MemoryReader& in, const uint8_t* objectsData, uint32_t dataSize);
+        std::vector<ObjectEntry> ReadObjectTable(IoUtils::MemoryReader& in);
 
-        nlohmann::fifo_map<std::string, int> GenerateArchiveNames();
+        size_t BeginObjectsData(IoUtils::MemoryWriter& out);
+        void WriteObjectData(IoUtils::MemoryWriter& out, MetadataObject& obj);
+        void EndObjectsData(IoUtils::MemoryWriter& out, size_t pos);
+        void WriteObjectsData(IoUtils::MemoryWriter& out);
+        void WriteArchiveList(IoUtils::MemoryWriter& out);
+        void WriteObjectsMetadata(IoUtils::MemoryWriter& out);
+        void WriteObjectArchiveNamesOffsets(IoUtils::MemoryWriter& out);
 
         const MetadataFileDef* m_FileDef = nullptr;
         bool m_DebugMode = false;
+        uint32_t m_NumWorkers = 1;
         std::vector<MetadataObject> m_Objects;
+        std::vector<Arena> m_Arenas; // storage for the values of m_Objects
         std::vector<uint32_t> m_InternalObjectOffsets;
-        std::unique_ptr<uint8_t[]> m_RawData;
+        std::vector<uint32_t> m_ObjectSizes;
+        std::vector<std::string> m_ObjectNames;  // in the order written
+        uint32_t m_ObjectNamesSize = 0;
+        FieldIO::FieldLayout m_Layout;
     };
 } // namespace AMT
@@ -1,31 +1,21 @@
 #include "pch.h"
 #include "MetadataObject.h"
+#include "HexUtils.h"
+#include "Stats.h"
 #include <cstring>
 
 namespace AMT
 {
-    uint32_t MetadataObject::GetHeaderHeaderSize() const
+    void MetadataObject::Read(const uint8_t* data, uint32_t size, Arena& arena, bool debugMode)
     {
-        uint32_t size = 1; // type ID byte
-        if (m_FileDef->hasNameOffset)
-            size += 4; // name offset uint32
-        return size;
-    }
-
-    uint32_t MetadataObject::GetHeaderSize() const
-    {
-        return GetHeaderHeaderSize() + FieldIO::GetFieldsSize(m_FileDef->headerFields, m_HeaderValues);
-    }
-
-    void MetadataObject::Read(uint8_t* data, uint32_t size, bool debugMode)
-    {
-        uint8_t* start = data;
+        const uint8_t* start = data;
 
         // Read type ID
         uint8_t typeId;
         memcpy(&typeId, data, 1);
         data += 1;
         m_TypeId = typeId;
+        m_TypeDef = m_FileDef->FindType(m_TypeId);
 
         // Skip name offset if present
         if (m_FileDef->hasNameOffset)
@@ -33,21 +23,29 @@ namespace AMT
             data += 4;
         }
 
+        // Bytes of the object left after data
+        auto remaining = [&]()
+        {
+            uint32_t consumed = static_cast<uint32_t>(data - start);
+            return consumed < size ? size - consumed : 0;
+        };
+
         // Read header fields
-        ordered_json* dbg = debugMode ? &m_DebugInfo : nullptr;
-        data = FieldIO::ReadFields(data, m_FileDef->headerFields, m_HeaderValues, dbg, 0);
+        std::vector<FieldIO::DebugEntry>* dbg = debugMode ? &m_DebugInfo : nullptr;
+        data = FieldIO::ReadFields(data, m_FileDef->headerProgram, arena, m_HeaderValues, dbg, remaining());
 
-        // Find the type definition
-        auto it = m_FileDef->types.find(m_TypeId);
-        if (it != m_FileDef->types.end())
+        // Type-specific fields
+        if (m_TypeDef)
         {
-            m_TypeName = it->second.name;
-            uint32_t remaining = size - static_cast<uint32_t>(data - start);
-            data = FieldIO::ReadFields(data, it->second.fields, m_TypeValues, dbg, remaining);
+            m_NamedType = m_TypeDef;
+            data = FieldIO::ReadFields(data, m_TypeDef->program, arena, m_TypeValues, dbg, remaining());
         }
+
+        if (Stats::IsEnabled())
+            CountFields(Stats::GetThreadCounters().fieldsRead);
     }
 
-    void MetadataObject::Write(std::ostream& out, uint32_t nameOffset)
+    void MetadataObject::Write(IoUtils::MemoryWriter& out, uint32_t nameOffset, FieldIO::FieldLayout* layout)
     {
         // Write type ID
         uint8_t id = static_cast<uint8_t>(m_TypeId);
@@ -60,127 +58,160 @@ namespace AMT
         }
 
         // Write header fields
-        FieldIO::WriteFields(out, m_FileDef->headerFields, m_HeaderValues);
+        FieldIO::WriteFields(out, m_FileDef->headerProgram, m_HeaderValues, layout);
 
         // Write type-specific fields
-        auto it = m_FileDef->types.find(m_TypeId);
-        if (it != m_FileDef->types.end())
+        if (m_TypeDef)
         {
-            FieldIO::WriteFields(out, it->second.fields, m_TypeValues);
+            FieldIO::WriteFields(out, m_TypeDef->program, m_TypeValues, layout);
         }
+
+        if (Stats::IsEnabled())
+            CountFields(Stats::GetThreadCounters().fieldsWritten);
     }
 
-    uint32_t MetadataObject::GetSize() const
+    void MetadataObject::CountFields(uint64_t* counts) const
     {
-        uint32_t size = GetHeaderSize();
-        auto it = m_FileDef->types.find(m_TypeId);
-        if (it != m_FileDef->types.end())
-        {
-            size += FieldIO::GetFieldsSize(it->second.fields, m_TypeValues);
-        }
-        return size;
+        FieldIO::CountFields(m_FileDef->headerProgram, m_HeaderValues, counts);
+        if (m_TypeDef)
+            FieldIO::CountFields(m_TypeDef->program, m_TypeValues, counts);
     }
 
     void MetadataObject::ToJson(ordered_json& j) const
     {
-        j["Type"] = m_TypeName;
+        j["Type"] = GetTypeName();
 
         // Header fields
-        for (const auto& [key, val] : m_HeaderValues.items())
-        {
-            j[key] = val;
-        }
+        FieldIO::AddMembersToJson(m_HeaderValues, j);
 
         // Type-specific fields
         ordered_json meta;
-        for (const auto& [key, val] : m_TypeValues.items())
-        {
-            meta[key] = val;
-        }
+        FieldIO::AddMembersToJson(m_TypeValues, meta);
         j["Metadata"] = meta;
 
-        // Debug info
-        if (!m_DebugInfo.is_null() && !m_DebugInfo.empty())
+        // Debug info, a field read twice keeps its first position
+        if (!m_DebugInfo.empty())
         {
-            j["_debug"] = m_DebugInfo;
+            ordered_json debug;
+            for (const auto& entry : m_DebugInfo)
+            {
+                debug[*entry.name] = HexUtils::ToHexSpaced(entry.data, entry.size);
+            }
+            j["_debug"] = debug;
         }
     }
 
-    void MetadataObject::FromJson(const ordered_json& j)
+    void MetadataObject::WriteJson(JsonWriter& writer) const
     {
-        std::string typeName = j.at("Type").get<std::string>();
-        m_TypeName = typeName;
+        static const std::string typeKey = "Type";
+        static const std::string metadataKey = "Metadata";
+        static const std::string debugKey = "_debug";
+
+        // The keys in the order ToJson sets them. A key set twice keeps its first
+        // position and its last value, like it does in ordered_json.
+        enum class EntryKind { TypeName, Header, Metadata, Debug };
+        struct Entry
+        {
+            const std::string* key;
+            EntryKind kind;
+            const FieldValue* value;
+        };
 
-        // Find type ID from name
-        for (const auto& [id, typeDef] : m_FileDef->types)
+        std::vector<Entry> entries;
+        auto add = [&](const std::string* key, EntryKind kind, const FieldValue* value)
         {
-            if (typeDef.name == typeName)
+            for (auto& entry : entries)
             {
-                m_TypeId = id;
-                break;
+                if (*entry.key == *key)
+                {
+                    entry.kind = kind;
+                    entry.value = value;
+                    return;
+                }
             }
-        }
+            entries.push_back({key, kind, value});
+        };
 
-        // Load header fields
-        m_HeaderValues = ordered_json::object();
-        for (const auto& field : m_FileDef->headerFields)
+        add(&typeKey, EntryKind::TypeName, nullptr);
+        for (uint32_t i = 0; i < m_HeaderValues.size; i++)
         {
-            if (j.contains(field.name))
-            {
-                m_HeaderValues[field.name] = j.at(field.name);
-            }
+            const FieldMember& member = m_HeaderValues.members[i];
+            if (member.value.IsPresent())
+                add(member.name, EntryKind::Header, &member.value);
         }
+        add(&metadataKey, EntryKind::Metadata, nullptr);
+        if (!m_DebugInfo.empty())
+            add(&debugKey, EntryKind::Debug, nullptr);
 
-        // Load type-specific fields
-        m_TypeValues = ordered_json::object();
-        auto it = m_FileDef->types.find(m_TypeId);
-        if (it != m_FileDef->types.end())
+        writer.BeginObject();
+        for (const auto& entry : entries)
         {
-            const auto& metaJson = j.at("Metadata");
-            for (const auto& field : it->second.fields)
+            writer.Key(*entry.key);
+            switch (entry.kind)
             {
-                if (metaJson.contains(field.name))
+                case EntryKind::TypeName:
+                    writer.String(GetTypeName());
+                    break;
+                case EntryKind::Header:
+                    FieldIO::WriteJson(writer, *entry.value);
+                    break;
+                case EntryKind::Metadata:
+                    // null rather than {} if there's nothing in it
+                    FieldIO::WriteJson(writer, m_TypeValues);
+                    break;
+                case EntryKind::Debug:
                 {
-                    m_TypeValues[field.name] = metaJson.at(field.name);
+                    // A field read twice keeps its first position
+                    std::vector<const FieldIO::DebugEntry*> debug;
+                    for (const auto& dbg : m_DebugInfo)
+                    {
+                        auto it = std::find_if(debug.begin(), debug.end(), [&](const FieldIO::DebugEntry* d) { return *d->name == *dbg.name; });
+                        if (it != debug.end())
+                            *it = &dbg;
+                        else
+                            debug.push_back(&dbg);
+                    }
+
+                    writer.BeginObject();
+                    for (const auto* dbg : debug)
+                    {
+                        writer.Key(*dbg->name);
+                        writer.String(HexUtils::ToHexSpaced(dbg->data, dbg->size));
+                    }
+                    writer.EndObject();
+                    break;
                 }
             }
         }
+        writer.EndObject();
     }
 
-    void MetadataObject::GetHashOffsets(std::vector<uint32_t>& out, uint32_t currentOffset) const
+    void MetadataObject::SetTypeName(const std::string& typeName)
     {
-        uint32_t headerHeaderSize = GetHeaderHeaderSize();
-        FieldIO::CollectAllHashOffsets(m_FileDef->headerFields, m_HeaderValues, out, currentOffset + headerHeaderSize);
-
-        uint32_t headerSize = GetHeaderSize();
-        auto it = m_FileDef->types.find(m_TypeId);
-        if (it != m_FileDef->types.end())
+        if (const MetadataTypeDef* typeDef = m_FileDef->FindType(typeName))
         {
-            FieldIO::CollectAllHashOffsets(it->second.fields, m_TypeValues, out, currentOffset + headerSize);
+            m_TypeId = typeDef->id;
+            m_TypeDef = typeDef;
+            m_NamedType = typeDef;
         }
-    }
-
-    void MetadataObject::GetArchiveOffsets(std::vector<uint32_t>& out, uint32_t currentOffset) const
-    {
-        uint32_t headerHeaderSize = GetHeaderHeaderSize();
-        FieldIO::CollectAllArchiveOffsets(m_FileDef->headerFields, m_HeaderValues, out, currentOffset + headerHeaderSize);
-
-        uint32_t headerSize = GetHeaderSize();
-        auto it = m_FileDef->types.find(m_TypeId);
-        if (it != m_FileDef->types.end())
+        else
         {
-            FieldIO::CollectAllArchiveOffsets(it->second.fields, m_TypeValues, out, currentOffset + headerSize);
+            m_TypeName = typeName;
+            m_NamedType = nullptr;
         }
     }
 
-    void MetadataObject::GetArchiveNames(nlohmann::fifo_map<std::string, int>& out) const
+    void MetadataObject::FromJson(const ordered_json& j, Arena& arena)
     {
-        FieldIO::CollectAllArchiveNames(m_FileDef->headerFields, m_HeaderValues, out);
+        SetTypeName(j.at("Type").get<std::string>());
+
+        // Load header fields
+        FieldIO::FromJson(m_FileDef->headerProgram, j, arena, m_HeaderValues);
 
-        auto it = m_FileDef->types.find(m_TypeId);
-        if (it != m_FileDef->types.end())
+        // Load type-specific fields
+        if (m_TypeDef)
         {
-            FieldIO::CollectAllArchiveNames(it->second.fields, m_TypeValues, out);
+            FieldIO::FromJson(m_TypeDef->program, j.at("Metadata"), arena, m_TypeValues);
         }
     }
 } // namespace AMT
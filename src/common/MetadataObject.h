@@ -3,6 +3,7 @@
 #include "MetadataTypeDef.h"
 #include "FieldIO.h"
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace AMT
@@ -11,32 +12,43 @@ namespace AMT
     {
     public:
         MetadataObject() = default;
-        MetadataObject(const MetadataFileDef* fileDef) : m_FileDef(fileDef) {}
+        MetadataObject(const MetadataFileDef* fileDef) : m_FileDef(fileDef), m_TypeDef(fileDef->FindType(0)) {}
 
-        void Read(uint8_t* data, uint32_t size, bool debugMode = false);
-        void Write(std::ostream& out, uint32_t nameOffset);
-        uint32_t GetSize() const;
+        // Decoded values are allocated from arena, which has to outlive the object
+        void Read(const uint8_t* data, uint32_t size, Arena& arena, bool debugMode = false);
 
-        void ToJson(ordered_json& j) const;
-        void FromJson(const ordered_json& j);
+        // Hash/archive patch offsets and archive names are added to layout if given
+        void Write(IoUtils::MemoryWriter& out, uint32_t nameOffset, FieldIO::FieldLayout* layout = nullptr);
 
-        void GetHashOffsets(std::vector<uint32_t>& out, uint32_t currentOffset) const;
-        void GetArchiveOffsets(std::vector<uint32_t>& out, uint32_t currentOffset) const;
-        void GetArchiveNames(nlohmann::fifo_map<std::string, int>& out) const;
+        void ToJson(ordered_json& j) const;
+        void WriteJson(JsonWriter& writer) const;
+        void FromJson(const ordered_json& j, Arena& arena);
 
         const std::string& GetName() const { return m_Name; }
         void SetName(const std::string& name) { m_Name = name; }
 
+        // Sets the type by name, types that don't exist in the file leave the ID unchanged
+        void SetTypeName(const std::string& typeName);
+
+        // Definition of the object's type, null if the file has no such type
+        const MetadataTypeDef* GetTypeDef() const { return m_TypeDef; }
+
+        // Values for loaders that fill them in directly
+        FieldValue& GetHeaderValues() { return m_HeaderValues; }
+        FieldValue& GetTypeValues() { return m_TypeValues; }
+
     private:
-        uint32_t GetHeaderHeaderSize() const;
-        uint32_t GetHeaderSize() const;
+        void CountFields(uint64_t* counts) const;
+        std::string_view GetTypeName() const { return m_NamedType ? m_NamedType->name : std::string_view(m_TypeName); }
 
         const MetadataFileDef* m_FileDef = nullptr;
         std::string m_Name;
         int m_TypeId = 0;
+        const MetadataTypeDef* m_TypeDef = nullptr;   // resolved whenever m_TypeId changes
+        const MetadataTypeDef* m_NamedType = nullptr; // type the name was taken from, otherwise it's m_TypeName
         std::string m_TypeName;
-        ordered_json m_HeaderValues;
-        ordered_json m_TypeValues;
-        ordered_json m_DebugInfo;
+        FieldValue m_HeaderValues;
+        FieldValue m_TypeValues;
+        std::vector<FieldIO::DebugEntry> m_DebugInfo;
     };
 } // namespace AMT
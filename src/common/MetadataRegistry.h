@@ -1,29 +1,68 @@
 #pragma once
 
 #include "MetadataTypeDef.h"
+#include <algorithm>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace AMT
 {
-    void RegisterSoundsSchema(std::map<std::string, MetadataFileDef>& registry);
-    void RegisterGameSchema(std::map<std::string, MetadataFileDef>& registry);
-    void RegisterCategoriesSchema(std::map<std::string, MetadataFileDef>& registry);
-    void RegisterEffectsSchema(std::map<std::string, MetadataFileDef>& registry);
-    void RegisterCurvesSchema(std::map<std::string, MetadataFileDef>& registry);
+    extern const MetadataFileSchema SoundsSchema;
+    extern const MetadataFileSchema GameSchema;
+    extern const MetadataFileSchema CategoriesSchema;
+    extern const MetadataFileSchema EffectsSchema;
+    extern const MetadataFileSchema CurvesSchema;
 
     class MetadataRegistry
     {
         std::map<std::string, MetadataFileDef> m_Defs;
 
+        void Register(const MetadataFileSchema& schema)
+        {
+            MetadataFileDef& def = m_Defs[std::string(schema.key)];
+            def.suffix = schema.suffix;
+            def.hasNameOffset = schema.hasNameOffset;
+            def.headerFields = schema.headerFields;
+
+            // Lower every field list into its flat form once, reading and writing only use that
+            def.headerProgram = FieldProgram::Compile(schema.headerFields);
+
+            // Types in ID order, a type listed later replaces one with the same ID
+            std::vector<const MetadataTypeSchema*> sorted;
+            for (const auto& type : schema.types)
+            {
+                sorted.push_back(&type);
+            }
+            std::stable_sort(sorted.begin(), sorted.end(), [](const MetadataTypeSchema* a, const MetadataTypeSchema* b) { return a->id < b->id; });
+
+            for (const MetadataTypeSchema* type : sorted)
+            {
+                MetadataTypeDef typeDef{type->id, type->name, type->fields, FieldProgram::Compile(type->fields)};
+                if (!def.types.empty() && def.types.back().id == type->id)
+                    def.types.back() = std::move(typeDef);
+                else
+                    def.types.push_back(std::move(typeDef));
+            }
+
+            // Objects look their type up by ID when read and by name when loaded from JSON
+            int maxId = def.types.empty() ? -1 : def.types.back().id;
+            def.typeIndexById.assign(static_cast<size_t>(maxId + 1), -1);
+            for (uint32_t i = 0; i < def.types.size(); i++)
+            {
+                def.typeIndexById[def.types[i].id] = static_cast<int32_t>(i);
+                def.typeIndexByName.try_emplace(def.types[i].name, i);
+            }
+        }
+
     public:
         void RegisterAll()
         {
-            RegisterSoundsSchema(m_Defs);
-            RegisterGameSchema(m_Defs);
-            RegisterCategoriesSchema(m_Defs);
-            RegisterEffectsSchema(m_Defs);
-            RegisterCurvesSchema(m_Defs);
+            Register(SoundsSchema);
+            Register(GameSchema);
+            Register(CategoriesSchema);
+            Register(EffectsSchema);
+            Register(CurvesSchema);
         }
 
         const MetadataFileDef* GetFileDef(const std::string& key) const
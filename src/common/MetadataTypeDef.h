@@ -1,24 +1,62 @@
 #pragma once
 
 #include "FieldDef.h"
-#include <map>
-#include <string>
+#include "FieldProgram.h"
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace AMT
 {
+    // Schemas as they are written down, constexpr tables in the SchemaRegistration files
+    struct MetadataTypeSchema
+    {
+        int id;
+        std::string_view name;
+        SchemaSpan<FieldDef> fields;
+    };
+
+    struct MetadataFileSchema
+    {
+        std::string_view key;
+        uint32_t suffix;
+        bool hasNameOffset;
+        SchemaSpan<FieldDef> headerFields;
+        SchemaSpan<MetadataTypeSchema> types;
+    };
+
     struct MetadataTypeDef
     {
         int id;
-        std::string name;
-        std::vector<FieldDef> fields;
+        std::string_view name;
+        SchemaSpan<FieldDef> fields;
+        FieldProgram program; // fields compiled by MetadataRegistry::RegisterAll
     };
 
     struct MetadataFileDef
     {
         uint32_t suffix;
         bool hasNameOffset;
-        std::vector<FieldDef> headerFields;
-        std::map<int, MetadataTypeDef> types;
+        SchemaSpan<FieldDef> headerFields;
+        FieldProgram headerProgram;
+        std::vector<MetadataTypeDef> types; // sorted by ID
+
+        // Indexes into types, built by MetadataRegistry
+        std::vector<int32_t> typeIndexById; // -1 for IDs the file has no type for
+        std::unordered_map<std::string_view, uint32_t> typeIndexByName; // lowest ID for names used twice
+
+        // Type with the given ID or name, null if the file has none
+        const MetadataTypeDef* FindType(int id) const
+        {
+            if (id < 0 || id >= static_cast<int>(typeIndexById.size()) || typeIndexById[id] < 0)
+                return nullptr;
+            return &types[typeIndexById[id]];
+        }
+
+        const MetadataTypeDef* FindType(std::string_view name) const
+        {
+            auto it = typeIndexByName.find(name);
+            return it != typeIndexByName.end() ? &types[it->second] : nullptr;
+        }
     };
 } // namespace AMT
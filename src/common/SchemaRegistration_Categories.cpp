@@ -3,34 +3,29 @@
 
 namespace AMT
 {
-    void RegisterCategoriesSchema(std::map<std::string, MetadataFileDef>& registry)
-    {
-        MetadataFileDef def;
-        def.suffix = 15;
-        def.hasNameOffset = true;
+    // audCategory
+    static constexpr FieldDef CategoryFields[] = {
+        UInt32("Flags"),
+        Int16("__field09"),
+        Int16("__field0b"),
+        Int16("__field0d"),
+        Int16("__field0f"),
+        Int16("__field11"),
+        Int16("__field13"),
+        Int16("__field15"),
+        Int16("__field17"),
+        UInt16("__field19"),
+        UInt16("__field1b"),
+        UInt16("__field1d"),
+        UInt16("__field1f"),
+        UInt16("__field21"),
+        Array("ChildCategories", TrackedHashElements, FieldKind::UInt8, true)
+    };
 
-        // CategoriesMetadataHeader, empty
-        def.headerFields = {};
+    static constexpr MetadataTypeSchema Types[] = {
+        {0, "audCategory", CategoryFields}
+    };
 
-        // audCategory
-        def.types[0] = {0, "audCategory", {
-            UInt32("Flags"),
-            Int16("__field09"), 
-            Int16("__field0b"),
-            Int16("__field0d"), 
-            Int16("__field0f"),
-            Int16("__field11"), 
-            Int16("__field13"),
-            Int16("__field15"), 
-            Int16("__field17"),
-            UInt16("__field19"), 
-            UInt16("__field1b"),
-            UInt16("__field1d"), 
-            UInt16("__field1f"),
-            UInt16("__field21"),
-            Array("ChildCategories", {{"", FieldKind::Hash, true}}, FieldKind::UInt8, true)
-        }};
-
-        registry["categories"] = std::move(def);
-    }
+    // CategoriesMetadataHeader is empty
+    constexpr MetadataFileSchema CategoriesSchema = {"categories", 15, true, {}, Types};
 } // namespace AMT
@@ -3,90 +3,83 @@
 
 namespace AMT
 {
-    void RegisterCurvesSchema(std::map<std::string, MetadataFileDef>& registry)
-    {
-        MetadataFileDef def;
-        def.suffix = 12;
-        def.hasNameOffset = true;
-
-        // CurvesMetadataHeader
-        def.headerFields = {
-            UInt32("Flags"),
-            UInt16("__unk09"),
-            UInt16("__unk0b"),
-            Float("MinInput"),
-            Float("MaxInput")
-        };
-
-        def.types[1] = {1, "audCurve_Constant", {
-            Float("Value")
-        }};
-
-        def.types[2] = {2, "audCurve_Linear", {
-            Float("LeftHandPairX"), 
-            Float("LeftHandPairY"),
-            Float("RightHandPairX"), 
-            Float("RightHandPairY")
-        }};
-
-        def.types[3] = {3, "audCurve_LinearDb", {
-            Float("LeftHandPairX"), 
-            Float("LeftHandPairY"),
-            Float("RightHandPairX"), 
-            Float("RightHandPairY")
-        }};
-
-        def.types[4] = {4, "audCurve_PiecewiseLinear", {
-            Array("Points", { Float("x"), Float("y") }, FieldKind::UInt32)
-        }};
-
-        def.types[5] = {5, "audCurve_EqualPower", {
-            UInt8("Flip")
-        }};
-
-        def.types[6] = {6, "audCurve_ValueTable", {
-            Array("Values", { Float("y") }, FieldKind::UInt16)
-        }};
-
-        def.types[7] = {7, "audCurve_Exponential", {
-            UInt8("Flip"), Float("Exponent")
-        }};
-
-        def.types[8] = {8, "audCurve_DecayingExponential", {
-            Float("HorizontalScaling")
-        }};
-
-        def.types[9] = {9, "audCurve_DecayingSquaredExponential", {
-            Float("HorizontalScaling")
-        }};
-
-        def.types[10] = {10, "audCurve_SineCurve", {
-            Float("StartPhase"), 
-            Float("EndPhase"),
-            Float("Frequency"), 
-            Float("VerticalScaling"), 
-            Float("VerticalOffset")
-        }};
-
-        def.types[11] = {11, "audCurve_OneOverX", {
-            Float("HorizontalScaling")
-        }};
-
-        def.types[12] = {12, "audCurve_OneOverXSquared", {
-            Float("HorizontalScaling")
-        }};
+    // CurvesMetadataHeader
+    static constexpr FieldDef HeaderFields[] = {
+        UInt32("Flags"),
+        UInt16("__unk09"),
+        UInt16("__unk0b"),
+        Float("MinInput"),
+        Float("MaxInput")
+    };
 
-        // empty
-        def.types[13] = {13, "audCurve_DefaultDistanceAttenuation", {}};
+    static constexpr FieldDef CurveConstantFields[] = { Float("Value") };
+
+    static constexpr FieldDef CurveLinearFields[] = {
+        Float("LeftHandPairX"),
+        Float("LeftHandPairY"),
+        Float("RightHandPairX"),
+        Float("RightHandPairY")
+    };
+
+    static constexpr FieldDef CurveLinearDbFields[] = {
+        Float("LeftHandPairX"),
+        Float("LeftHandPairY"),
+        Float("RightHandPairX"),
+        Float("RightHandPairY")
+    };
+
+    static constexpr FieldDef CurvePiecewiseLinearPoints[] = { Float("x"), Float("y") };
+
+    static constexpr FieldDef CurvePiecewiseLinearFields[] = { Array("Points", CurvePiecewiseLinearPoints, FieldKind::UInt32) };
+
+    static constexpr FieldDef CurveEqualPowerFields[] = { UInt8("Flip") };
+
+    static constexpr FieldDef CurveValueTableValues[] = { Float("y") };
+
+    static constexpr FieldDef CurveValueTableFields[] = { Array("Values", CurveValueTableValues, FieldKind::UInt16) };
+
+    static constexpr FieldDef CurveExponentialFields[] = { UInt8("Flip"), Float("Exponent") };
 
-        def.types[14] = {14, "audCurve_DefaultDistanceAttenuationClamped", {
-            Int16("MaxGain")
-        }};
+    static constexpr FieldDef CurveDecayingExponentialFields[] = { Float("HorizontalScaling") };
 
-        def.types[15] = {15, "audCurve_DistanceAttenuationValueTable", {
-            Array("Values", { Float("y") }, FieldKind::UInt16)
-        }};
+    static constexpr FieldDef CurveDecayingSquaredExponentialFields[] = { Float("HorizontalScaling") };
+
+    static constexpr FieldDef CurveSineCurveFields[] = {
+        Float("StartPhase"),
+        Float("EndPhase"),
+        Float("Frequency"),
+        Float("VerticalScaling"),
+        Float("VerticalOffset")
+    };
+
+    static constexpr FieldDef CurveOneOverXFields[] = { Float("HorizontalScaling") };
+
+    static constexpr FieldDef CurveOneOverXSquaredFields[] = { Float("HorizontalScaling") };
+
+    static constexpr FieldDef CurveDefaultDistanceAttenuationClampedFields[] = { Int16("MaxGain") };
+
+    static constexpr FieldDef CurveDistanceAttenuationValueTableValues[] = { Float("y") };
+
+    static constexpr FieldDef CurveDistanceAttenuationValueTableFields[] = { Array("Values", CurveDistanceAttenuationValueTableValues, FieldKind::UInt16) };
+
+    static constexpr MetadataTypeSchema Types[] = {
+        {1, "audCurve_Constant", CurveConstantFields},
+        {2, "audCurve_Linear", CurveLinearFields},
+        {3, "audCurve_LinearDb", CurveLinearDbFields},
+        {4, "audCurve_PiecewiseLinear", CurvePiecewiseLinearFields},
+        {5, "audCurve_EqualPower", CurveEqualPowerFields},
+        {6, "audCurve_ValueTable", CurveValueTableFields},
+        {7, "audCurve_Exponential", CurveExponentialFields},
+        {8, "audCurve_DecayingExponential", CurveDecayingExponentialFields},
+        {9, "audCurve_DecayingSquaredExponential", CurveDecayingSquaredExponentialFields},
+        {10, "audCurve_SineCurve", CurveSineCurveFields},
+        {11, "audCurve_OneOverX", CurveOneOverXFields},
+        {12, "audCurve_OneOverXSquared", CurveOneOverXSquaredFields},
+        // empty
+        {13, "audCurve_DefaultDistanceAttenuation", {}},
+        {14, "audCurve_DefaultDistanceAttenuationClamped", CurveDefaultDistanceAttenuationClampedFields},
+        {15, "audCurve_DistanceAttenuationValueTable", CurveDistanceAttenuationValueTableFields}
+    };
 
-        registry["curves"] = std::move(def);
-    }
+    constexpr MetadataFileSchema CurvesSchema = {"curves", 12, true, HeaderFields, Types};
 } // namespace AMT
@@ -3,45 +3,38 @@
 
 namespace AMT
 {
-    void RegisterEffectsSchema(std::map<std::string, MetadataFileDef>& registry)
-    {
-        MetadataFileDef def;
-        def.suffix = 11;
-        def.hasNameOffset = true;
-
-        // EffectsMetadataHeader
-        def.headerFields = {
-            UInt32("Flags"),
-            UInt8("__unk08"),
-            Hash("ChildEffect", true),
-            UInt8("__unk0E")
-        };
-
+    // EffectsMetadataHeader
+    static constexpr FieldDef HeaderFields[] = {
+        UInt32("Flags"),
+        UInt8("__unk08"),
+        Hash("ChildEffect", true),
+        UInt8("__unk0E")
+    };
+
+    static constexpr FieldDef ReverbEffectFields[] = {
+        Float("__field00"),
+        Float("__field04"),
+        Float("__field08"),
+        Float("__field0C")
+    };
+
+    static constexpr FieldDef PlaceholderFields[] = { Placeholder("Data") };
+
+    static constexpr MetadataTypeSchema Types[] = {
         // empty
-        def.types[1] = {1, "audNullEffect", {}};
-
-        def.types[2] = {2, "audReverbEffect", {
-            Float("__field00"), 
-            Float("__field04"),
-            Float("__field08"), 
-            Float("__field0C")
-        }};
-
+        {1, "audNullEffect", {}},
+        {2, "audReverbEffect", ReverbEffectFields},
         // empty
-        def.types[3] = {3, "audBiquadFilterEffect", {}};
-
+        {3, "audBiquadFilterEffect", {}},
         // empty
-        def.types[4] = {4, "audConvolutionEffect", {}};
-
+        {4, "audConvolutionEffect", {}},
         // empty
-        def.types[5] = {5, "audCompressorEffect", {}};
-
+        {5, "audCompressorEffect", {}},
         // empty
-        def.types[6] = {6, "audWaveshaperEffect", {}};
-
+        {6, "audWaveshaperEffect", {}},
         // placeholder
-        def.types[7] = {7, "audDelayEffect", { Placeholder("Data") }};
+        {7, "audDelayEffect", PlaceholderFields}
+    };
 
-        registry["effects"] = std::move(def);
-    }
+    constexpr MetadataFileSchema EffectsSchema = {"effects", 11, true, HeaderFields, Types};
 } // namespace AMT
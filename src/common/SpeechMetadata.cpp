@@ -1,71 +1,102 @@
 #include "pch.h"
 #include "SpeechMetadata.h"
+#include "HexUtils.h"
+#include "Stats.h"
 #include <algorithm>
 
 namespace AMT
 {
 
-void SpeechMetadataMgr::Read(std::istream &in)
+void SpeechMetadataMgr::Read(const uint8_t *data, size_t size)
 {
-    uint32_t numVarData = IoUtils::ReadData<uint32_t>(in);
-    m_VariationData.resize(numVarData);
-    if (numVarData > 0)
-    {
-        IoUtils::ReadData(in, m_VariationData.data(), numVarData);
-    }
+    IoUtils::MemoryReader in(data, size);
 
-    uint32_t numContexts = IoUtils::ReadData<uint32_t>(in);
-    m_Contexts.clear();
-    m_Contexts.reserve(numContexts);
+    uint32_t numVarData = in.Read<uint32_t>();
+    const uint8_t *varData = in.Skip(numVarData);
+    m_VariationData.assign(varData, varData + numVarData);
+
+    // Both tables are arrays of packed records, decoded straight from the buffer
+    uint32_t numContexts = in.Read<uint32_t>();
+    const uint8_t *contexts = in.Skip(static_cast<size_t>(numContexts) * ContextRecordSize);
+    m_Contexts.resize(numContexts);
 
     for (uint32_t i = 0; i < numContexts; i++)
     {
-        ContextEntry c;
-        c.bankNameIndex = IoUtils::ReadData<uint32_t>(in);
-        c.variationDataOffsetBytes = IoUtils::ReadData<int32_t>(in);
-        c.nameHash = IoUtils::ReadData<uint32_t>(in);
-        c.contextData = IoUtils::ReadData<uint8_t>(in);
-        c.numVariations = IoUtils::ReadData<uint8_t>(in);
-        m_Contexts.push_back(c);
+        const uint8_t *rec = contexts + i * ContextRecordSize;
+        ContextEntry &c = m_Contexts[i];
+        c.bankNameIndex            = IoUtils::LoadUnaligned<uint32_t>(rec);
+        c.variationDataOffsetBytes = IoUtils::LoadUnaligned<int32_t>(rec + 4);
+        c.nameHash                 = IoUtils::LoadUnaligned<uint32_t>(rec + 8);
+        c.contextData              = rec[12];
+        c.numVariations            = rec[13];
     }
 
-    uint32_t numVoices = IoUtils::ReadData<uint32_t>(in);
-    m_Voices.clear();
-    m_Voices.reserve(numVoices);
+    uint32_t numVoices = in.Read<uint32_t>();
+    const uint8_t *voices = in.Skip(static_cast<size_t>(numVoices) * VoiceRecordSize);
+    m_Voices.resize(numVoices);
 
     for (uint32_t i = 0; i < numVoices; i++)
     {
-        VoiceEntry v;
-        uint32_t contextsOffsetBytes = IoUtils::ReadData<uint32_t>(in);
-        v.nameHash    = IoUtils::ReadData<uint32_t>(in);
-        v.numContexts = IoUtils::ReadData<uint16_t>(in);
-
-        // Convert byte offset into context index (each context entry is 14 bytes)
-        v.firstContextIndex = contextsOffsetBytes / 14;
-        m_Voices.push_back(v);
+        const uint8_t *rec = voices + i * VoiceRecordSize;
+        VoiceEntry &v = m_Voices[i];
+        uint32_t contextsOffsetBytes = IoUtils::LoadUnaligned<uint32_t>(rec);
+        v.nameHash    = IoUtils::LoadUnaligned<uint32_t>(rec + 4);
+        v.numContexts = IoUtils::LoadUnaligned<uint16_t>(rec + 8);
+
+        // Convert byte offset into context index
+        v.firstContextIndex = static_cast<uint32_t>(contextsOffsetBytes / ContextRecordSize);
     }
 
-    uint32_t numStrings = IoUtils::ReadData<uint32_t>(in);
+    ReadStringTable(in);
+    Stats::AddObjects(numContexts);
+}
+
+void SpeechMetadataMgr::Read(std::istream &in)
+{
+    std::vector<uint8_t> buffer = IoUtils::ReadRemaining(in);
+    Read(buffer.data(), buffer.size());
+}
+
+// Only registers the bank names, skipping the context and voice tables
+void SpeechMetadataMgr::ReadNames(const uint8_t *data, size_t size)
+{
+    IoUtils::MemoryReader in(data, size);
+
+    uint32_t numVarData = in.Read<uint32_t>();
+    in.Skip(numVarData);
+
+    uint32_t numContexts = in.Read<uint32_t>();
+    in.Skip(static_cast<size_t>(numContexts) * ContextRecordSize);
+
+    uint32_t numVoices = in.Read<uint32_t>();
+    in.Skip(static_cast<size_t>(numVoices) * VoiceRecordSize);
+
+    ReadStringTable(in);
+}
+
+void SpeechMetadataMgr::ReadStringTable(IoUtils::MemoryReader &in)
+{
+    uint32_t numStrings = in.Read<uint32_t>();
     m_Strings.clear();
 
     if (numStrings > 0)
     {
-        std::vector<uint32_t> offsets(numStrings);
-        IoUtils::ReadData(in, offsets.data(), numStrings * 4);
-
-        // Read the rest of the stream as the string heap
-        auto heapStart = in.tellg();
-        in.seekg(0, std::ios::end);
-        auto heapSize = in.tellg() - heapStart;
-        in.seekg(heapStart);
+        const uint8_t *offsets = in.Skip(static_cast<size_t>(numStrings) * 4);
 
-        std::vector<char> heap(static_cast<size_t>(heapSize));
-        IoUtils::ReadData(in, heap.data(), static_cast<uint32_t>(heapSize));
+        // The rest of the buffer is the string heap
+        size_t heapSize = in.GetRemaining();
+        const char *heap = reinterpret_cast<const char *>(in.Skip(heapSize));
 
         m_Strings.reserve(numStrings);
         for (uint32_t i = 0; i < numStrings; i++)
         {
-            std::string s(heap.data() + offsets[i]);
+            uint32_t offset;
+            memcpy(&offset, offsets + i * 4, 4);
+            if (offset > heapSize)
+                throw std::runtime_error("Speech string out of bounds");
+
+            const char *end = static_cast<const char *>(memchr(heap + offset, 0, heapSize - offset));
+            std::string s(heap + offset, end ? end : heap + heapSize);
             std::replace(s.begin(), s.end(), '\\', '/');
             HashManager::Instance()->AddHash(s);
             m_Strings.push_back(std::move(s));
@@ -73,12 +104,41 @@ void SpeechMetadataMgr::Read(std::istream &in)
     }
 }
 
-void SpeechMetadataMgr::ToJson(ordered_json &j) const
+// A byte array as written by ToJson
+static ordered_json BytesToJson(const uint8_t *data, size_t size, bool hexBytes)
+{
+    if (hexBytes)
+        return HexUtils::ToHex(data, size);
+    return ordered_json(std::vector<uint8_t>(data, data + size));
+}
+
+// Appends the bytes of an array of numbers or a hex string to out
+static void AppendBytes(const ordered_json &j, const char *name, std::vector<uint8_t> &out)
+{
+    if (j.is_string())
+    {
+        const auto &text = j.get_ref<const std::string &>();
+        size_t start = out.size();
+        out.resize(start + text.size() / 2);
+
+        size_t errorPos;
+        if (!HexUtils::DecodeHex(text.data(), text.size(), out.data() + start, errorPos))
+            throw std::runtime_error(std::string("Invalid hex data in ") + name + " at position " + std::to_string(errorPos));
+        return;
+    }
+
+    for (const auto &b : j)
+    {
+        out.push_back(b.get<uint8_t>());
+    }
+}
+
+void SpeechMetadataMgr::ToJson(ordered_json &j, bool hexBytes) const
 {
     // String table
     j["StringTable"] = m_Strings;
     // Raw variation data blob
-    j["RawVariationData"] = m_VariationData;
+    j["RawVariationData"] = BytesToJson(m_VariationData.data(), m_VariationData.size(), hexBytes);
 
     // Voices
     ordered_json voicesObj;
@@ -102,17 +162,15 @@ void SpeechMetadataMgr::ToJson(ordered_json &j) const
             ctxJson["variationDataOffset"] = ctx.variationDataOffsetBytes;
             ctxJson["numVariations"] = ctx.numVariations;
 
-            // Variation data
-            ordered_json varArr = ordered_json::array();
+            // Variation data, cut short at the end of the blob
+            size_t off = 0, count = 0;
             if (ctx.variationDataOffsetBytes >= 0)
             {
-                uint32_t off = static_cast<uint32_t>(ctx.variationDataOffsetBytes);
-                for (uint8_t k = 0; k < ctx.numVariations && off + k < m_VariationData.size(); k++)
-                {
-                    varArr.push_back(m_VariationData[off + k]);
-                }
+                off = static_cast<uint32_t>(ctx.variationDataOffsetBytes);
+                if (off < m_VariationData.size())
+                    count = std::min<size_t>(ctx.numVariations, m_VariationData.size() - off);
             }
-            ctxJson["VariationData"] = varArr;
+            ctxJson["VariationData"] = BytesToJson(m_VariationData.data() + (count ? off : 0), count, hexBytes);
 
             contextsArr.push_back(ctxJson);
         }
@@ -151,10 +209,7 @@ SpeechMetadataMgr::FromJson(const ordered_json &j)
     bool hasRawVarData = j.contains("RawVariationData");
     if (hasRawVarData)
     {
-        for (const auto &b : j.at("RawVariationData"))
-        {
-            m_VariationData.push_back(b.get<uint8_t>());
-        }
+        AppendBytes(j.at("RawVariationData"), "RawVariationData", m_VariationData);
     }
 
     if (!j.contains("Voices")) return;
@@ -197,57 +252,56 @@ SpeechMetadataMgr::FromJson(const ordered_json &j)
             }
             else
             {
-                const auto &varArr = ctxJson.at("VariationData");
-                if (varArr.empty())
-                {
-                    c.variationDataOffsetBytes = -1;
-                    c.numVariations = static_cast<uint8_t>(varArr.size());
-                }
-                else
-                {
-                    c.variationDataOffsetBytes = static_cast<int32_t>(m_VariationData.size());
-                    c.numVariations = static_cast<uint8_t>(varArr.size());
-                    for (const auto &vd : varArr)
-                    {
-                        m_VariationData.push_back(vd.get<uint8_t>());
-                    }
-                }
+                size_t start = m_VariationData.size();
+                AppendBytes(ctxJson.at("VariationData"), "VariationData", m_VariationData);
+
+                size_t count = m_VariationData.size() - start;
+                c.variationDataOffsetBytes = count == 0 ? -1 : static_cast<int32_t>(start);
+                c.numVariations = static_cast<uint8_t>(count);
             }
             m_Contexts.push_back(c);
         }
         m_Voices.push_back(v);
     }
+    Stats::AddObjects(m_Contexts.size());
 }
 
 void SpeechMetadataMgr::Write(std::ostream &out)
 {
-    IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(m_VariationData.size()));
-    if (!m_VariationData.empty())
-    {
-        out.write(reinterpret_cast<const char *>(m_VariationData.data()), m_VariationData.size());
-    }
+    // The whole file is encoded into one buffer and written with a single call
+    IoUtils::MemoryWriter buf;
+    buf.ReserveCapacity(12 + m_VariationData.size() + m_Contexts.size() * ContextRecordSize + m_Voices.size() * VoiceRecordSize);
+
+    IoUtils::WriteData<uint32_t>(buf, static_cast<uint32_t>(m_VariationData.size()));
+    buf.Write(m_VariationData.data(), m_VariationData.size());
 
-    IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(m_Contexts.size()));
-    for (const auto &c : m_Contexts)
+    IoUtils::WriteData<uint32_t>(buf, static_cast<uint32_t>(m_Contexts.size()));
+    uint8_t *contexts = buf.GetData() + buf.Reserve(m_Contexts.size() * ContextRecordSize);
+    for (size_t i = 0; i < m_Contexts.size(); i++)
     {
-        IoUtils::WriteData<uint32_t>(out, c.bankNameIndex);
-        IoUtils::WriteData<int32_t>(out, c.variationDataOffsetBytes);
-        IoUtils::WriteData<uint32_t>(out, c.nameHash);
-        IoUtils::WriteData<uint8_t>(out, c.contextData);
-        IoUtils::WriteData<uint8_t>(out, c.numVariations);
+        const ContextEntry &c = m_Contexts[i];
+        uint8_t *rec = contexts + i * ContextRecordSize;
+        IoUtils::StoreUnaligned(rec, c.bankNameIndex);
+        IoUtils::StoreUnaligned(rec + 4, c.variationDataOffsetBytes);
+        IoUtils::StoreUnaligned(rec + 8, c.nameHash);
+        rec[12] = c.contextData;
+        rec[13] = c.numVariations;
     }
 
-    IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(m_Voices.size()));
-    for (const auto &v : m_Voices)
+    IoUtils::WriteData<uint32_t>(buf, static_cast<uint32_t>(m_Voices.size()));
+    uint8_t *voices = buf.GetData() + buf.Reserve(m_Voices.size() * VoiceRecordSize);
+    for (size_t i = 0; i < m_Voices.size(); i++)
     {
-        // Convert context index back to byte offset (14 bytes per entry)
-        uint32_t offsetBytes = v.firstContextIndex * 14;
-        IoUtils::WriteData<uint32_t>(out, offsetBytes);
-        IoUtils::WriteData<uint32_t>(out, v.nameHash);
-        IoUtils::WriteData<uint16_t>(out, v.numContexts);
+        const VoiceEntry &v = m_Voices[i];
+        uint8_t *rec = voices + i * VoiceRecordSize;
+
+        // Convert context index back to byte offset
+        IoUtils::StoreUnaligned(rec, static_cast<uint32_t>(v.firstContextIndex * ContextRecordSize));
+        IoUtils::StoreUnaligned(rec + 4, v.nameHash);
+        IoUtils::StoreUnaligned(rec + 8, v.numContexts);
     }
 
-    IoUtils::WriteData<uint32_t>(out, static_cast<uint32_t>(m_Strings.size()));
+    IoUtils::WriteData<uint32_t>(buf, static_cast<uint32_t>(m_Strings.size()));
 
     if (!m_Strings.empty())
     {
@@ -264,8 +318,10 @@ void SpeechMetadataMgr::Write(std::ostream &out)
             heap.append(winStr);
             heap.push_back('\0');
         }
-        out.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * 4);
-        out.write(heap.data(), heap.size());
+        buf.Write(offsets.data(), offsets.size() * 4);
+        buf.Write(heap.data(), heap.size());
     }
+
+    buf.WriteTo(out);
 }
 }; // namespace AMT
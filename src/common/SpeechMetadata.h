@@ -12,12 +12,25 @@ namespace AMT
     class SpeechMetadataMgr
     {
     public:
+        // Parse a whole file held in memory (e.g. a memory mapping)
+        void Read  (const uint8_t *data, size_t size);
         void Read  (std::istream &in);
+        void ReadNames (const uint8_t *data, size_t size);
         void Write (std::ostream &out);
-        void ToJson  (ordered_json &j) const;
+        // With hexBytes, variation data is written as hex strings rather than arrays of
+        // numbers. FromJson takes either form.
+        void ToJson  (ordered_json &j, bool hexBytes = false) const;
         void FromJson(const ordered_json &j);
 
+        size_t GetNumVoices  () const { return m_Voices.size(); }
+        size_t GetNumContexts() const { return m_Contexts.size(); }
+
     private:
+        void ReadStringTable (IoUtils::MemoryReader &in);
+
+        // Sizes of the packed records in the file
+        static constexpr size_t ContextRecordSize = 14;
+        static constexpr size_t VoiceRecordSize = 10;
 
         struct ContextEntry
         {
@@ -0,0 +1,300 @@
+#include "pch.h"
+#include "Stats.h"
+#include "FieldIO.h"
+#include <iomanip>
+#include <mutex>
+
+namespace AMT
+{
+    namespace Stats
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct FileStats
+        {
+            std::string name;
+            double phaseSeconds[NumPhases] = {};
+            uint64_t objects = 0;
+            uint64_t bytesIn = 0;
+            uint64_t bytesOut = 0;
+
+            void Merge(const FileStats& other)
+            {
+                for (size_t i = 0; i < NumPhases; i++)
+                    phaseSeconds[i] += other.phaseSeconds[i];
+                objects += other.objects;
+                bytesIn += other.bytesIn;
+                bytesOut += other.bytesOut;
+            }
+        };
+
+        static const char* const s_PhaseNames[NumPhases] = {
+            "register_all", "read_hashes", "read_names", "read", "to_json", "write_json",
+            "dump", "parse", "from_json", "write", "save_hashes"
+        };
+
+        static const char* const s_FieldKindNames[NumFieldKinds] = {
+            "UInt8", "UInt16", "UInt32", "Int8", "Int16", "Int32", "Float", "Hash", "String",
+            "Array", "FixedArray", "Struct", "OptionalBitfield", "Enum", "Placeholder"
+        };
+
+        static std::mutex s_Mutex;
+        static Clock::time_point s_StartTime;
+        static std::vector<std::unique_ptr<Counters>> s_ThreadCounters;
+        static std::map<std::string, FileStats> s_Files;
+        static FileStats s_Run; // phases outside any file
+
+        static thread_local Counters* t_Counters = nullptr;
+        static thread_local FileStats* t_File = nullptr;
+        static thread_local ScopedPhase* t_Phase = nullptr;
+
+        void Enable()
+        {
+            g_Enabled = true;
+            s_StartTime = Clock::now();
+        }
+
+        Counters& GetThreadCounters()
+        {
+            // Owned by the list, so they outlive their thread and are still there for the report
+            if (!t_Counters)
+            {
+                std::lock_guard<std::mutex> lock(s_Mutex);
+                t_Counters = s_ThreadCounters.emplace_back(std::make_unique<Counters>()).get();
+            }
+            return *t_Counters;
+        }
+
+        void AddObjects(uint64_t count)
+        {
+            if (t_File)
+                t_File->objects += count;
+        }
+
+        void AddBytesIn(uint64_t bytes)
+        {
+            if (t_File)
+                t_File->bytesIn += bytes;
+        }
+
+        void AddBytesOut(uint64_t bytes)
+        {
+            if (t_File)
+                t_File->bytesOut += bytes;
+        }
+
+        FileScope::FileScope(const std::string& name)
+        {
+            if (!g_Enabled)
+                return;
+
+            m_File = std::make_unique<FileStats>();
+            m_File->name = name;
+            m_Previous = t_File;
+            t_File = m_File.get();
+        }
+
+        FileScope::~FileScope()
+        {
+            if (!m_File)
+                return;
+
+            t_File = m_Previous;
+
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            FileStats& file = s_Files[m_File->name];
+            file.name = m_File->name;
+            file.Merge(*m_File);
+        }
+
+        ScopedPhase::ScopedPhase(Phase phase) : m_Phase(phase)
+        {
+            if (!g_Enabled)
+                return;
+
+            m_Active = true;
+            m_Start = Clock::now();
+            m_Parent = t_Phase;
+            if (m_Parent)
+                m_Parent->AddTime(m_Start);
+            t_Phase = this;
+        }
+
+        ScopedPhase::~ScopedPhase()
+        {
+            if (!m_Active)
+                return;
+
+            Clock::time_point now = Clock::now();
+            AddTime(now);
+            t_Phase = m_Parent;
+            if (m_Parent)
+                m_Parent->m_Start = now;
+        }
+
+        void ScopedPhase::AddTime(Clock::time_point now)
+        {
+            double seconds = std::chrono::duration<double>(now - m_Start).count();
+            size_t phase = static_cast<size_t>(m_Phase);
+            if (t_File)
+            {
+                t_File->phaseSeconds[phase] += seconds;
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(s_Mutex);
+                s_Run.phaseSeconds[phase] += seconds;
+            }
+        }
+
+        // Everything summed up, taken under the lock
+        struct Totals
+        {
+            double wallSeconds = 0;
+            FileStats all;
+            Counters counters;
+            std::vector<FileStats> files;
+        };
+
+        static Totals GetTotals()
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+
+            Totals totals;
+            totals.wallSeconds = std::chrono::duration<double>(Clock::now() - s_StartTime).count();
+            totals.all.Merge(s_Run);
+            for (const auto& [name, file] : s_Files)
+            {
+                totals.all.Merge(file);
+                totals.files.push_back(file);
+            }
+
+            Counters& sum = totals.counters;
+            for (const auto& counters : s_ThreadCounters)
+            {
+                for (size_t i = 0; i < NumFieldKinds; i++)
+                {
+                    sum.fieldsRead[i] += counters->fieldsRead[i];
+                    sum.fieldsWritten[i] += counters->fieldsWritten[i];
+                }
+                sum.hashHits += counters->hashHits;
+                sum.hashMisses += counters->hashMisses;
+            }
+            return totals;
+        }
+
+        void PrintReport(std::ostream& out)
+        {
+            Totals totals = GetTotals();
+            std::ios_base::fmtflags flags = out.flags();
+            out << std::fixed << std::setprecision(3);
+
+            out << std::left << std::setw(16) << "Phase" << std::right << std::setw(10) << "Seconds" << '\n';
+            for (size_t i = 0; i < NumPhases; i++)
+            {
+                if (totals.all.phaseSeconds[i] > 0)
+                    out << std::left << std::setw(16) << s_PhaseNames[i] << std::right << std::setw(10) << totals.all.phaseSeconds[i] << '\n';
+            }
+            out << std::left << std::setw(16) << "wall" << std::right << std::setw(10) << totals.wallSeconds << '\n';
+
+            // Only the phases some file went through get a column
+            bool used[NumPhases] = {};
+            size_t nameWidth = 4;
+            for (const FileStats& file : totals.files)
+            {
+                for (size_t i = 0; i < NumPhases; i++)
+                    used[i] |= file.phaseSeconds[i] > 0;
+                nameWidth = std::max<size_t>(nameWidth, file.name.size());
+            }
+
+            out << '\n' << std::left << std::setw(nameWidth) << "File" << std::right
+                << std::setw(10) << "Objects" << std::setw(12) << "Bytes in" << std::setw(12) << "Bytes out";
+            for (size_t i = 0; i < NumPhases; i++)
+            {
+                if (used[i])
+                    out << std::setw(12) << s_PhaseNames[i];
+            }
+            out << '\n';
+
+            for (const FileStats& file : totals.files)
+            {
+                out << std::left << std::setw(nameWidth) << file.name << std::right
+                    << std::setw(10) << file.objects << std::setw(12) << file.bytesIn << std::setw(12) << file.bytesOut;
+                for (size_t i = 0; i < NumPhases; i++)
+                {
+                    if (used[i])
+                        out << std::setw(12) << file.phaseSeconds[i];
+                }
+                out << '\n';
+            }
+
+            out << std::left << std::setw(nameWidth) << "total" << std::right
+                << std::setw(10) << totals.all.objects << std::setw(12) << totals.all.bytesIn << std::setw(12) << totals.all.bytesOut << '\n';
+
+            // Containers without a prefix of their own (Struct, FixedArray) are counted
+            // through their members
+            const Counters& counters = totals.counters;
+            out << '\n' << std::left << std::setw(18) << "Field kind" << std::right << std::setw(12) << "Read" << std::setw(12) << "Written" << '\n';
+            for (size_t i = 0; i < NumFieldKinds; i++)
+            {
+                if (counters.fieldsRead[i] || counters.fieldsWritten[i])
+                {
+                    out << std::left << std::setw(18) << s_FieldKindNames[i] << std::right
+                        << std::setw(12) << counters.fieldsRead[i] << std::setw(12) << counters.fieldsWritten[i] << '\n';
+                }
+            }
+
+            out << "\nHash names: " << counters.hashHits << " found, " << counters.hashMisses << " unknown" << std::endl;
+            out.flags(flags);
+        }
+
+        void WriteReportJson(std::ostream& out)
+        {
+            Totals totals = GetTotals();
+
+            auto phasesToJson = [](const FileStats& file)
+            {
+                ordered_json j = ordered_json::object();
+                for (size_t i = 0; i < NumPhases; i++)
+                {
+                    if (file.phaseSeconds[i] > 0)
+                        j[s_PhaseNames[i]] = file.phaseSeconds[i];
+                }
+                return j;
+            };
+
+            ordered_json report;
+            report["wall_seconds"] = totals.wallSeconds;
+            report["phases"] = phasesToJson(totals.all);
+            report["objects"] = totals.all.objects;
+            report["bytes_in"] = totals.all.bytesIn;
+            report["bytes_out"] = totals.all.bytesOut;
+
+            report["files"] = ordered_json::object();
+            for (const FileStats& file : totals.files)
+            {
+                ordered_json& entry = report["files"][file.name];
+                entry["objects"] = file.objects;
+                entry["bytes_in"] = file.bytesIn;
+                entry["bytes_out"] = file.bytesOut;
+                entry["phases"] = phasesToJson(file);
+            }
+
+            const Counters& counters = totals.counters;
+            report["fields_read"] = ordered_json::object();
+            report["fields_written"] = ordered_json::object();
+            for (size_t i = 0; i < NumFieldKinds; i++)
+            {
+                if (counters.fieldsRead[i])
+                    report["fields_read"][s_FieldKindNames[i]] = counters.fieldsRead[i];
+                if (counters.fieldsWritten[i])
+                    report["fields_written"][s_FieldKindNames[i]] = counters.fieldsWritten[i];
+            }
+
+            report["hash_hits"] = counters.hashHits;
+            report["hash_misses"] = counters.hashMisses;
+
+            out << report.dump(4) << std::endl;
+        }
+    } // namespace Stats
+} // namespace AMT
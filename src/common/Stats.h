@@ -0,0 +1,98 @@
+#pragma once
+
+#include "FieldDef.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace AMT
+{
+    // Phase timers and counters behind ivam --stats. Everything is a no-op until
+    // Enable() is called, which has to happen before any worker thread starts.
+    namespace Stats
+    {
+        enum class Phase : uint8_t
+        {
+            RegisterAll,
+            ReadHashes,
+            ReadNames,
+            Read,
+            ToJson,
+            WriteJson,
+            Dump,
+            Parse,
+            FromJson,
+            Write,
+            SaveHashes,
+            Count
+        };
+
+        constexpr size_t NumPhases = static_cast<size_t>(Phase::Count);
+        constexpr size_t NumFieldKinds = static_cast<size_t>(FieldKind::Placeholder) + 1;
+
+        struct FileStats;
+
+        // Counters of one thread, summed up for the report
+        struct Counters
+        {
+            uint64_t fieldsRead[NumFieldKinds] = {};
+            uint64_t fieldsWritten[NumFieldKinds] = {};
+            uint64_t hashHits = 0;      // HashToString found a name
+            uint64_t hashMisses = 0;    // HashToString fell back to the hex form
+        };
+
+        inline bool g_Enabled = false;
+
+        void Enable();
+        inline bool IsEnabled() { return g_Enabled; }
+
+        Counters& GetThreadCounters();
+
+        // Added to the file of the FileScope open on this thread, if any
+        void AddObjects(uint64_t count);
+        void AddBytesIn(uint64_t bytes);
+        void AddBytesOut(uint64_t bytes);
+
+        // Attributes the phases and counts of this thread to a file until destroyed.
+        // Scopes of the same name are merged.
+        class FileScope
+        {
+        public:
+            explicit FileScope(const std::string& name);
+            ~FileScope();
+
+            FileScope(const FileScope&) = delete;
+            FileScope& operator=(const FileScope&) = delete;
+
+        private:
+            std::unique_ptr<FileStats> m_File;
+            FileStats* m_Previous = nullptr;
+        };
+
+        // Times a phase of the current file, or of the whole run outside a FileScope.
+        // A phase started inside another pauses it, so no time is counted twice.
+        class ScopedPhase
+        {
+        public:
+            explicit ScopedPhase(Phase phase);
+            ~ScopedPhase();
+
+            ScopedPhase(const ScopedPhase&) = delete;
+            ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+        private:
+            void AddTime(std::chrono::steady_clock::time_point now);
+
+            Phase m_Phase;
+            bool m_Active = false;
+            ScopedPhase* m_Parent = nullptr;
+            std::chrono::steady_clock::time_point m_Start;
+        };
+
+        // Everything gathered so far, as a table or as JSON
+        void PrintReport(std::ostream& out);
+        void WriteReportJson(std::ostream& out);
+    } // namespace Stats
+} // namespace AMT
@@ -3,29 +3,48 @@
 #include "common/MetadataRegistry.h"
 #include "common/HashManager.h"
 #include "common/SpeechMetadata.h"
+#include "common/JobScheduler.h"
+#include "common/MappedFile.h"
+#include "common/Stats.h"
 
+#include <charconv>
 #include <fstream>
 #include <functional>
 #include <vector>
 
 static AMT::MetadataRegistry g_Registry;
 
-void DeserialiseMetadata(const std::string& file, const std::string& schemaKey, bool debugMode = false)
+uint64_t GetJobCost(const std::string& file)
+{
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(file, ec);
+    return ec ? 0 : size;
+}
+
+void DeserialiseMetadata(const std::string& file, const std::string& schemaKey, bool debugMode = false, uint32_t numWorkers = 1)
 {
     const AMT::MetadataFileDef* def = g_Registry.GetFileDef(schemaKey);
     if (!def) return;
 
-    std::ifstream input(file, std::ios_base::binary);
-    if (!input.good()) return;
+    AMT::MappedFile input;
+    if (!input.Open(file)) return;
 
-    AMT::MetadataFile mgr(def, debugMode);
-    mgr.Read(input);
+    AMT::Stats::FileScope stats(file);
+    AMT::Stats::AddBytesIn(input.GetSize());
 
-    AMT::ordered_json j;
-    mgr.ToJson(j);
+    AMT::MetadataFile mgr(def, debugMode);
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::Read);
+        mgr.SetNumWorkers(numWorkers);
+        mgr.Read(input.GetData(), input.GetSize());
+        input.Close();
+    }
 
+    // Streamed straight from the decoded objects, no document is built
+    AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::WriteJson);
     std::ofstream out(file + ".json");
-    out << j.dump(4);
+    mgr.WriteJson(out);
+    AMT::Stats::AddBytesOut(static_cast<uint64_t>(out.tellp()));
 }
 
 void SerialiseMetadata(const std::string& file, const std::string& schemaKey)
@@ -33,32 +52,59 @@ void SerialiseMetadata(const std::string& file, const std::string& schemaKey)
     const AMT::MetadataFileDef* def = g_Registry.GetFileDef(schemaKey);
     if (!def) return;
 
-    std::ifstream input(file + ".json");
-    if (!input.good()) return;
+    AMT::MappedFile input;
+    if (!input.Open(file + ".json")) return;
 
-    AMT::ordered_json j;
-    input >> j;
+    AMT::Stats::FileScope stats(file);
+    AMT::Stats::AddBytesIn(input.GetSize());
 
+    // Objects are encoded as they are parsed, the document is never built. Parsing
+    // counts as from_json, the encoding inside it as write.
     AMT::MetadataFile mgr(def);
-    mgr.FromJson(j);
+    AMT::IoUtils::MemoryWriter writer;
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::FromJson);
+        mgr.WriteFromJson(reinterpret_cast<const char*>(input.GetData()), input.GetSize(), writer);
+        input.Close();
+    }
 
+    AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::Write);
     std::ofstream out(file + ".GEN", std::ios_base::binary);
-    mgr.Write(out);
+    writer.WriteTo(out);
+    AMT::Stats::AddBytesOut(writer.GetSize());
 }
 
 template <typename T>
-void DeserialiseMetadataLegacy(const std::string& file)
+void DeserialiseMetadataLegacy(const std::string& file, bool hexBytes = false)
 {
     T mgr;
-    std::ifstream input(file, std::ios_base::binary);
-    if (!input.good()) return;
+    AMT::MappedFile input;
+    if (!input.Open(file)) return;
 
-    mgr.Read(input);
+    AMT::Stats::FileScope stats(file);
+    AMT::Stats::AddBytesIn(input.GetSize());
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::Read);
+        mgr.Read(input.GetData(), input.GetSize());
+        input.Close();
+    }
 
     AMT::ordered_json j;
-    mgr.ToJson(j);
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::ToJson);
+        mgr.ToJson(j, hexBytes);
+    }
+
+    std::string text;
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::Dump);
+        text = j.dump(4);
+    }
+
+    AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::Write);
     std::ofstream out(file + ".json");
-    out << j.dump(4);
+    out << text;
+    AMT::Stats::AddBytesOut(text.size());
 }
 
 template <typename T>
@@ -67,26 +113,69 @@ void SerialiseMetadataLegacy(const std::string& file)
     std::ifstream input(file + ".json");
     if (!input.good()) return;
 
+    AMT::Stats::FileScope stats(file);
+    AMT::Stats::AddBytesIn(GetJobCost(file + ".json"));
+
     AMT::ordered_json j;
-    input >> j;
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::Parse);
+        input >> j;
+    }
 
     T mgr;
-    mgr.FromJson(j);
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::FromJson);
+        mgr.FromJson(j);
+    }
+
+    AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::Write);
     std::ofstream out(file + ".GEN", std::ios_base::binary);
     mgr.Write(out);
+    AMT::Stats::AddBytesOut(static_cast<uint64_t>(out.tellp()));
+}
+
+void ReadMetadataNames(const std::string& file, const std::string& schemaKey)
+{
+    const AMT::MetadataFileDef* def = g_Registry.GetFileDef(schemaKey);
+    if (!def) return;
+
+    AMT::MappedFile input;
+    if (!input.Open(file)) return;
+
+    AMT::Stats::FileScope stats(file);
+    AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::ReadNames);
+    AMT::MetadataFile mgr(def);
+    mgr.ReadNames(input.GetData(), input.GetSize());
+}
+
+template <typename T>
+void ReadMetadataNamesLegacy(const std::string& file)
+{
+    AMT::MappedFile input;
+    if (!input.Open(file)) return;
+
+    AMT::Stats::FileScope stats(file);
+    AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::ReadNames);
+    T mgr;
+    mgr.ReadNames(input.GetData(), input.GetSize());
 }
 
-void ReadHashes(const std::string& file)
+void ReadHashes(const std::string& file, uint32_t numWorkers)
 {
-    std::ifstream input(file);
-    std::string key;
-    while (std::getline(input, key))
+    AMT::MappedFile input;
+    if (!input.Open(file)) return;
+
+    auto collisions = AMT::HashManager::Instance()->AddHashes(reinterpret_cast<const char*>(input.GetData()), input.GetSize(), numWorkers);
+    for (const auto& collision : collisions)
     {
-        AMT::HashManager::Instance()->AddHash(key);
+        char hashText[10];
+        AMT::HashManager::FormatHash(collision.hash, hashText);
+        std::cout << "Hash collision in " << file << ": " << collision.previous << " and " << collision.name
+                  << " are both " << std::string_view(hashText, sizeof(hashText)) << std::endl;
     }
 }
 
-void ProcessMetadataFiles(bool generateMode, bool debugMode)
+void ProcessMetadataFiles(bool generateMode, bool debugMode, bool hexBytes, uint32_t numWorkers)
 {
     const std::vector<std::pair<std::string, std::string>> categoriesFiles = {
         {"CATEGORIES.DAT15", "categories"},
@@ -126,50 +215,136 @@ void ProcessMetadataFiles(bool generateMode, bool debugMode)
         "SPEECH.DAT", "EP1_SPEECH.DAT", "EP2_SPEECH.DAT"
     };
 
-    auto processFiles = [&](const std::vector<std::pair<std::string, std::string>>& files) {
-        for (const auto& [filename, schema] : files)
-        {
-            if (generateMode)
-                SerialiseMetadata(filename, schema);
-            else
-                DeserialiseMetadata(filename, schema, debugMode);
-        }
-    };
+    std::vector<std::pair<std::string, std::string>> allFiles;
+    for (const auto* files : {&categoriesFiles, &effectsFiles, &curvesFiles, &soundFiles, &gameFiles})
+    {
+        allFiles.insert(allFiles.end(), files->begin(), files->end());
+    }
+
+    // Names are resolved while objects are decoded, so register every file's names up
+    // front in a fixed order. The jobs then share a read-only dictionary and produce
+    // the same output no matter how they are scheduled.
+    if (!generateMode)
+    {
+        for (const auto& [filename, schema] : allFiles)
+            ReadMetadataNames(filename, schema);
+
+        for (const auto& filename : speechFiles)
+            ReadMetadataNamesLegacy<AMT::SpeechMetadataMgr>(filename);
+    }
 
-    processFiles(categoriesFiles);
-    processFiles(effectsFiles);
-    processFiles(curvesFiles);
-    processFiles(soundFiles);
-    processFiles(gameFiles);
+    AMT::JobScheduler scheduler(numWorkers);
+
+    // Large files also decode their objects in parallel. That work is queued on the
+    // scheduler's threads, not on threads of its own, so once the small files are done
+    // their threads help with the big ones and there are never more than numWorkers.
+    const uint32_t numFileWorkers = scheduler.GetNumWorkers();
+
+    for (const auto& [filename, schema] : allFiles)
+    {
+        if (generateMode)
+            scheduler.AddJob(GetJobCost(filename + ".json"), [=] { SerialiseMetadata(filename, schema); });
+        else
+            scheduler.AddJob(GetJobCost(filename), [=] { DeserialiseMetadata(filename, schema, debugMode, numFileWorkers); });
+    }
 
     for (const auto& filename : speechFiles)
     {
         if (generateMode)
-            SerialiseMetadataLegacy<AMT::SpeechMetadataMgr>(filename);
+            scheduler.AddJob(GetJobCost(filename + ".json"), [=] { SerialiseMetadataLegacy<AMT::SpeechMetadataMgr>(filename); });
         else
-            DeserialiseMetadataLegacy<AMT::SpeechMetadataMgr>(filename);
+            scheduler.AddJob(GetJobCost(filename), [=] { DeserialiseMetadataLegacy<AMT::SpeechMetadataMgr>(filename, hexBytes); });
     }
+
+    AMT::HashManager::Instance()->SetReadOnly(true);
+    scheduler.Run();
+    AMT::HashManager::Instance()->SetReadOnly(false);
 }
 
-int main(int argc, char** argv)
+// Whole argument as a number, false if it is anything else
+static bool ParseCount(const char* text, uint32_t& count)
 {
-    ReadHashes("Hashes.txt");
-
-    g_Registry.RegisterAll();
+    const char* end = text + strlen(text);
+    auto [ptr, ec] = std::from_chars(text, end, count);
+    return ec == std::errc() && ptr == end && ptr != text;
+}
 
+int main(int argc, char** argv)
+{
     bool generateMode = false;
     bool debugMode = false;
+    bool hexBytes = false;
+    bool printStats = false;
+    std::string statsPath;
+    uint32_t numWorkers = 0;
 
-    if (argc >= 2)
+    for (int i = 1; i < argc; i++)
     {
-        std::string arg(argv[1]);
+        std::string arg(argv[i]);
         if (arg == "gen")
             generateMode = true;
         else if (arg == "debug")
             debugMode = true;
+        else if (arg == "--hex-bytes")
+            hexBytes = true;
+        else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc)
+        {
+            if (!ParseCount(argv[++i], numWorkers))
+            {
+                std::cout << "Error: " << arg << " needs a number of workers, not " << argv[i] << std::endl;
+                std::cout << "Usage: ivam [gen] [debug] [--hex-bytes] [-j jobs] [--stats] [--stats-json file]" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--stats")
+            printStats = true;
+        else if (arg == "--stats-json" && i + 1 < argc)
+            statsPath = argv[++i];
     }
 
-    ProcessMetadataFiles(generateMode, debugMode);
+    // Arguments are read first so the schema registration can be timed too
+    if (printStats || !statsPath.empty())
+        AMT::Stats::Enable();
+
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::RegisterAll);
+        g_Registry.RegisterAll();
+    }
+
+    // Hashes.txt is only parsed again after it changes, otherwise the binary cache built
+    // from it is mapped
+    {
+        AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::ReadHashes);
+        if (!AMT::HashManager::Instance()->LoadCache("Hashes.bin", "Hashes.txt"))
+            ReadHashes("Hashes.txt", numWorkers);
+    }
+
+    try
+    {
+        ProcessMetadataFiles(generateMode, debugMode, hexBytes, numWorkers);
+
+        // Keep the names found in the files for the next run
+        {
+            AMT::Stats::ScopedPhase phase(AMT::Stats::Phase::SaveHashes);
+            AMT::HashManager::Instance()->SaveCache("Hashes.bin", "Hashes.txt");
+        }
+
+        if (printStats)
+            AMT::Stats::PrintReport(std::cout);
+
+        if (!statsPath.empty())
+        {
+            std::ofstream out(statsPath);
+            if (!out)
+                throw std::runtime_error("Can't write " + statsPath);
+            AMT::Stats::WriteReportJson(out);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
 
     return 0;
 }
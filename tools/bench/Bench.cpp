@@ -0,0 +1,303 @@
+#include "pch.h"
+#include "BenchUtils.h"
+#include "ToolArgs.h"
+#include "common/HashManager.h"
+#include "common/MappedFile.h"
+#include "common/MetadataFile.h"
+#include "common/MetadataRegistry.h"
+#include "common/SpeechMetadata.h"
+#include <limits>
+#include <sstream>
+
+// ivam-bench [options] [schema:]file...
+//
+// Runs every stage ivam goes through on each file and writes the timings as JSON.
+// The schema is taken from the file name unless given in front of it, e.g.
+// sounds:big.dat15.
+//
+//   -n, --iterations N   runs of each stage, the fastest is reported (default 5)
+//   -j, --jobs N         worker threads for reading metadata files (default 1, 0 = one per core)
+//   --hashes FILE        name list to load first (default Hashes.txt if present)
+//   -o, --out FILE       where to write the report (default stdout)
+
+using AMT::Bench::AllocCounts;
+
+static AMT::MetadataRegistry g_Registry;
+
+struct StageResult
+{
+    std::string name;
+    double seconds = std::numeric_limits<double>::infinity(); // fastest run
+    uint64_t bytes = 0;   // size of the binary or JSON text the stage reads or produces
+    uint64_t objects = 0;
+    uint64_t allocations = 0; // of the last run
+    uint64_t allocatedBytes = 0;
+};
+
+// Runs func iterations times and returns what the last run produced. Results of
+// earlier runs are destroyed outside the timed part.
+template <typename Func>
+static auto RunStage(std::vector<StageResult>& stages, const char* name, uint32_t iterations, Func&& func)
+{
+    StageResult stage;
+    stage.name = name;
+
+    decltype(func()) result{};
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        AllocCounts before = AMT::Bench::GetAllocCounts();
+        AMT::Bench::Stopwatch timer;
+        auto value = func();
+        double seconds = timer.GetSeconds();
+        AllocCounts after = AMT::Bench::GetAllocCounts();
+
+        stage.seconds = std::min<double>(stage.seconds, seconds);
+        stage.allocations = after.count - before.count;
+        stage.allocatedBytes = after.bytes - before.bytes;
+        result = std::move(value);
+    }
+
+    stages.push_back(stage);
+    return result;
+}
+
+static std::vector<StageResult> BenchMetadataFile(const AMT::MetadataFileDef* def, const uint8_t* data, size_t size,
+                                                  uint32_t iterations, uint32_t numWorkers, uint64_t& numObjects)
+{
+    std::vector<StageResult> stages;
+
+    auto file = RunStage(stages, "read", iterations, [&]
+    {
+        auto result = std::make_unique<AMT::MetadataFile>(def);
+        result->SetNumWorkers(numWorkers);
+        result->Read(data, size);
+        return result;
+    });
+    numObjects = file->GetNumObjects();
+
+    auto document = RunStage(stages, "to_json", iterations, [&]
+    {
+        AMT::ordered_json result;
+        file->ToJson(result);
+        return result;
+    });
+
+    auto text = RunStage(stages, "dump", iterations, [&] { return document.dump(4); });
+    document = AMT::ordered_json();
+
+    RunStage(stages, "write_json", iterations, [&]
+    {
+        std::ostringstream out;
+        file->WriteJson(out);
+        return out.str();
+    });
+    file.reset();
+
+    document = RunStage(stages, "parse", iterations, [&] { return AMT::ordered_json::parse(text); });
+
+    file = RunStage(stages, "from_json", iterations, [&]
+    {
+        auto result = std::make_unique<AMT::MetadataFile>(def);
+        result->FromJson(document);
+        return result;
+    });
+    document = AMT::ordered_json();
+
+    auto binary = RunStage(stages, "write", iterations, [&]
+    {
+        AMT::IoUtils::MemoryWriter out;
+        file->Write(out);
+        return out;
+    });
+    file.reset();
+
+    RunStage(stages, "write_from_json", iterations, [&]
+    {
+        AMT::IoUtils::MemoryWriter out;
+        AMT::MetadataFile(def).WriteFromJson(text.data(), text.size(), out);
+        return out;
+    });
+
+    // Stages that turn one form into the other are measured against the binary size,
+    // the ones that only handle text against the JSON size
+    for (StageResult& stage : stages)
+    {
+        bool isText = stage.name == "dump" || stage.name == "write_json" || stage.name == "parse";
+        stage.bytes = isText ? text.size() : (stage.name == "write" || stage.name == "write_from_json") ? binary.GetSize() : size;
+        stage.objects = numObjects;
+    }
+    return stages;
+}
+
+static std::vector<StageResult> BenchSpeech(const uint8_t* data, size_t size, uint32_t iterations, uint64_t& numObjects)
+{
+    std::vector<StageResult> stages;
+
+    auto mgr = RunStage(stages, "read", iterations, [&]
+    {
+        auto result = std::make_unique<AMT::SpeechMetadataMgr>();
+        result->Read(data, size);
+        return result;
+    });
+    numObjects = mgr->GetNumContexts();
+
+    auto document = RunStage(stages, "to_json", iterations, [&]
+    {
+        AMT::ordered_json result;
+        mgr->ToJson(result);
+        return result;
+    });
+
+    auto text = RunStage(stages, "dump", iterations, [&] { return document.dump(4); });
+    mgr.reset();
+
+    document = RunStage(stages, "parse", iterations, [&] { return AMT::ordered_json::parse(text); });
+
+    mgr = RunStage(stages, "from_json", iterations, [&]
+    {
+        auto result = std::make_unique<AMT::SpeechMetadataMgr>();
+        result->FromJson(document);
+        return result;
+    });
+
+    auto binary = RunStage(stages, "write", iterations, [&]
+    {
+        std::ostringstream out;
+        mgr->Write(out);
+        return out.str();
+    });
+
+    for (StageResult& stage : stages)
+    {
+        bool isText = stage.name == "dump" || stage.name == "parse";
+        stage.bytes = isText ? text.size() : stage.name == "write" ? binary.size() : size;
+        stage.objects = numObjects;
+    }
+    return stages;
+}
+
+static AMT::ordered_json StageToJson(const StageResult& stage)
+{
+    AMT::ordered_json j;
+    j["seconds"] = stage.seconds;
+    j["bytes"] = stage.bytes;
+    j["mb_per_s"] = stage.seconds > 0 ? stage.bytes / stage.seconds / (1024.0 * 1024.0) : 0.0;
+    j["objects_per_s"] = stage.seconds > 0 ? stage.objects / stage.seconds : 0.0;
+    j["allocations"] = stage.allocations;
+    j["allocated_bytes"] = stage.allocatedBytes;
+    return j;
+}
+
+int main(int argc, char** argv)
+{
+    g_Registry.RegisterAll();
+
+    uint32_t iterations = 5;
+    uint32_t numWorkers = 1;
+    std::string hashesPath = "Hashes.txt";
+    std::string outPath;
+    std::vector<std::string> inputs;
+
+    const char* usage = "Usage: ivam-bench [-n iterations] [-j jobs] [--hashes file] [-o report.json] [schema:]file...";
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if ((arg == "-n" || arg == "--iterations") && i + 1 < argc)
+        {
+            if (!AMT::Bench::ParseCount(argv[++i], iterations))
+                return AMT::Bench::ReportBadValue(arg, argv[i], usage);
+            iterations = std::max<uint32_t>(1, iterations);
+        }
+        else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc)
+        {
+            if (!AMT::Bench::ParseCount(argv[++i], numWorkers))
+                return AMT::Bench::ReportBadValue(arg, argv[i], usage);
+        }
+        else if (arg == "--hashes" && i + 1 < argc)
+            hashesPath = argv[++i];
+        else if ((arg == "-o" || arg == "--out") && i + 1 < argc)
+            outPath = argv[++i];
+        else
+            inputs.push_back(arg);
+    }
+
+    if (inputs.empty())
+    {
+        std::cout << usage << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        AMT::Bench::LoadHashList(hashesPath);
+
+        AMT::ordered_json report;
+        report["iterations"] = iterations;
+        report["jobs"] = numWorkers;
+        report["files"] = AMT::ordered_json::array();
+
+        for (const std::string& input : inputs)
+        {
+            // "schema:path", a single letter before the colon is a drive
+            std::string schema, path = input;
+            size_t colon = input.find(':');
+            if (colon != std::string::npos && colon > 1)
+            {
+                schema = input.substr(0, colon);
+                path = input.substr(colon + 1);
+            }
+            if (schema.empty())
+                schema = AMT::Bench::GuessSchema(path);
+
+            AMT::MappedFile file;
+            if (!file.Open(path))
+                throw std::runtime_error("Can't open " + path);
+
+            std::vector<StageResult> stages;
+            uint64_t numObjects = 0;
+            if (schema == "speech")
+            {
+                stages = BenchSpeech(file.GetData(), file.GetSize(), iterations, numObjects);
+            }
+            else
+            {
+                const AMT::MetadataFileDef* def = g_Registry.GetFileDef(schema);
+                if (!def)
+                    throw std::runtime_error("No schema for " + path + ", name one as schema:" + path);
+                stages = BenchMetadataFile(def, file.GetData(), file.GetSize(), iterations, numWorkers, numObjects);
+            }
+
+            AMT::ordered_json entry;
+            entry["file"] = path;
+            entry["schema"] = schema;
+            entry["size"] = file.GetSize();
+            entry["objects"] = numObjects;
+            for (const StageResult& stage : stages)
+                entry["stages"][stage.name] = StageToJson(stage);
+            report["files"].push_back(std::move(entry));
+        }
+
+        // Only for the whole run, a peak can't be told apart per file once it is reached
+        report["peak_rss"] = AMT::Bench::GetPeakRss();
+
+        if (outPath.empty())
+        {
+            std::cout << report.dump(4) << std::endl;
+        }
+        else
+        {
+            std::ofstream out(outPath);
+            if (!out)
+                throw std::runtime_error("Can't write " + outPath);
+            out << report.dump(4) << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "pch.h"
+#include "BenchUtils.h"
+#include "common/HashManager.h"
+#include "common/MappedFile.h"
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+static std::atomic<uint64_t> s_AllocCount{0};
+static std::atomic<uint64_t> s_AllocBytes{0};
+
+// Replacements for the global allocation functions that count what passes through
+// them. The nothrow forms call these, the aligned forms are left alone since
+// nothing in the tool over-aligns.
+void *operator new(std::size_t size)
+{
+    s_AllocCount.fetch_add(1, std::memory_order_relaxed);
+    s_AllocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace AMT
+{
+    namespace Bench
+    {
+        AllocCounts GetAllocCounts()
+        {
+            return {s_AllocCount.load(std::memory_order_relaxed), s_AllocBytes.load(std::memory_order_relaxed)};
+        }
+
+        uint64_t GetPeakRss()
+        {
+#ifdef _WIN32
+            PROCESS_MEMORY_COUNTERS counters;
+            if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+                return 0;
+            return counters.PeakWorkingSetSize;
+#else
+            rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) != 0)
+                return 0;
+#ifdef __APPLE__
+            return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+            return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+#endif
+#endif
+        }
+
+        std::string GuessSchema(const std::string &path)
+        {
+            std::string name = std::filesystem::path(path).filename().string();
+            for (char &c : name)
+                c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+            auto endsWith = [&](const char *suffix)
+            {
+                size_t length = strlen(suffix);
+                return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+            };
+
+            if (endsWith("SPEECH.DAT"))
+                return "speech";
+            if (endsWith("CATEGORIES.DAT15"))
+                return "categories";
+            if (endsWith(".DAT11"))
+                return "effects";
+            if (endsWith(".DAT12"))
+                return "curves";
+            if (endsWith(".DAT15"))
+                return "sounds";
+            if (endsWith(".DAT16"))
+                return "game";
+            return {};
+        }
+
+        bool LoadHashList(const std::string &path)
+        {
+            MappedFile input;
+            if (!input.Open(path))
+                return false;
+
+            HashManager::Instance()->AddHashes(reinterpret_cast<const char *>(input.GetData()), input.GetSize());
+            return true;
+        }
+    } // namespace Bench
+} // namespace AMT
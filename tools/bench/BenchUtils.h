@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace AMT
+{
+    namespace Bench
+    {
+        class Stopwatch
+        {
+            std::chrono::steady_clock::time_point m_Start = std::chrono::steady_clock::now();
+
+        public:
+            void Restart() { m_Start = std::chrono::steady_clock::now(); }
+
+            double GetSeconds() const
+            {
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+            }
+        };
+
+        // Totals of every operator new call made by the process so far. The counting
+        // operators are defined in BenchUtils.cpp, linking it into a tool enables them.
+        struct AllocCounts
+        {
+            uint64_t count = 0;
+            uint64_t bytes = 0;
+        };
+
+        AllocCounts GetAllocCounts();
+
+        // Largest resident set of the process so far, in bytes (0 if unknown)
+        uint64_t GetPeakRss();
+
+        // Schema key ivam uses for a file ("speech" for SPEECH.DAT), empty if the
+        // name doesn't say
+        std::string GuessSchema(const std::string &path);
+
+        // Adds the names in a Hashes.txt style list, returns false if it can't be opened
+        bool LoadHashList(const std::string &path);
+    } // namespace Bench
+} // namespace AMT
@@ -0,0 +1,358 @@
+#include "pch.h"
+#include "BenchUtils.h"
+#include "ToolArgs.h"
+#include "common/FieldIO.h"
+#include "common/HashManager.h"
+#include "common/MetadataRegistry.h"
+#include "corpus/CorpusGenerator.h"
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+// ivam-fieldbench [options]
+//
+// Times the FieldIO kernels on records made of one kind of field, and on the fields of a
+// few object types, and reports nanoseconds per field and MB/s of binary data.
+//
+//   -n, --iterations N   runs of each kernel, the fastest is reported (default 5)
+//   -r, --records N      records per case (default 4096)
+//   -f, --filter TEXT    only the cases whose name contains TEXT
+//   -o, --out FILE       also write the results as JSON
+
+using namespace AMT;
+
+// Children of the composite kinds
+static constexpr EnumValue BenchEnum[] = {
+    {0, "BENCH_ZERO"}, {1, "BENCH_ONE"}, {2, "BENCH_TWO"}, {3, "BENCH_THREE"},
+    {5, "BENCH_FIVE"}, {8, "BENCH_EIGHT"}, {13, "BENCH_THIRTEEN"}, {21, "BENCH_TWENTYONE"}
+};
+
+static constexpr FieldDef PointFields[] = { Float("x"), Float("y") };
+static constexpr FieldDef MixedFields[] = { UInt32("Flags"), Hash("Sound"), Float("Volume"), Int16("Pitch") };
+static constexpr FieldDef NestedFields[] = { Hash("Name"), Array("Values", UInt8Elements) };
+
+static constexpr FieldDef BitfieldFields[] = {
+    UInt8("A"), UInt16("B"), UInt32("C"), Float("D"),
+    Hash("E"), Int32("F"), UInt8("G"), UInt16("H")
+};
+
+// Each kind case is a record of copies of the field, named Field0, Field1...
+struct KindCase
+{
+    const char* name;
+    FieldDef field;
+    uint32_t copies;
+};
+
+static const KindCase s_KindCases[] = {
+    {"UInt8", UInt8(""), 16},
+    {"UInt16", UInt16(""), 16},
+    {"UInt32", UInt32(""), 16},
+    {"Int8", Int8(""), 16},
+    {"Int16", Int16(""), 16},
+    {"Int32", Int32(""), 16},
+    {"Float", Float(""), 16},
+    {"Hash", Hash(""), 16},
+    {"Hash (tracked)", Hash("", true), 16},
+    {"Hash (archive)", Hash("", false, true), 16},
+    {"String", String(""), 16},
+    {"Array (UInt8)", Array("", UInt8Elements), 16},
+    {"Array (tracked hashes)", Array("", TrackedHashElements, FieldKind::UInt8, true), 16},
+    {"Array (struct)", Array("", PointFields), 16},
+    {"Array (nested)", Array("", NestedFields), 16},
+    {"FixedArray", FixedArray("", PointFields, 4), 16},
+    {"Struct", Struct("", MixedFields), 16},
+    {"OptionalBitfield", OptionalBitfield("", BitfieldFields), 16},
+    {"Enum", Enum("", FieldKind::UInt8, BenchEnum), 16},
+    {"Placeholder (16)", Placeholder("", 16), 16},
+    {"Placeholder (rest)", Placeholder(""), 1}, // runs to the end of the record
+};
+
+// Object types whose fields are timed as they are
+struct TypeCase
+{
+    const char* schema;
+    const char* type;
+};
+
+static const TypeCase s_TypeCases[] = {
+    {"sounds", "audRandomizedSound"},
+    {"sounds", "audMultitrackSound"},
+    {"curves", "audCurve_PiecewiseLinear"},
+    {"game", "gameAmbientZone"},
+    {"game", "gameAmbientEmitter"},
+};
+
+static const char* const s_Kernels[] = {"read", "size", "write", "write_layout", "write_json", "from_json"};
+static constexpr size_t NumKernels = std::size(s_Kernels);
+
+struct BenchCase
+{
+    std::string name;
+    SchemaSpan<FieldDef> fields;
+    std::vector<std::string> fieldNames; // storage for fieldDefs
+    std::vector<FieldDef> fieldDefs;     // kind cases only
+};
+
+struct CaseResult
+{
+    std::string name;
+    uint32_t fieldsPerRecord = 0;
+    uint64_t records = 0;
+    uint64_t bytes = 0; // binary size of all records
+    double seconds[NumKernels];
+};
+
+static MetadataRegistry g_Registry;
+
+static double TimeKernel(uint32_t iterations, const std::function<void()>& kernel)
+{
+    double best = std::numeric_limits<double>::infinity();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        Bench::Stopwatch timer;
+        kernel();
+        best = std::min<double>(best, timer.GetSeconds());
+    }
+    return best;
+}
+
+static CaseResult RunCase(const BenchCase& bench, CorpusGenerator& generator, uint32_t numRecords, uint32_t iterations)
+{
+    FieldProgram program = FieldProgram::Compile(bench.fields);
+
+    // Records back to back, each as long as the generator made it
+    IoUtils::MemoryWriter input;
+    std::vector<uint32_t> offsets;
+    for (uint32_t r = 0; r < numRecords; r++)
+    {
+        offsets.push_back(static_cast<uint32_t>(input.GetSize()));
+        generator.WriteFields(input, bench.fields);
+    }
+    offsets.push_back(static_cast<uint32_t>(input.GetSize()));
+
+    CaseResult result;
+    result.name = bench.name;
+    result.fieldsPerRecord = static_cast<uint32_t>(bench.fields.size());
+    result.records = numRecords;
+    result.bytes = input.GetSize();
+
+    Arena arena(1024 * 1024);
+    std::vector<FieldValue> values(numRecords);
+    auto readAll = [&]
+    {
+        arena.Reset();
+        for (uint32_t r = 0; r < numRecords; r++)
+            FieldIO::ReadFields(input.GetData() + offsets[r], program, arena, values[r], nullptr, offsets[r + 1] - offsets[r]);
+    };
+
+    // The values read last are used by the other kernels
+    volatile uint64_t sink = 0;
+    result.seconds[0] = TimeKernel(iterations, readAll);
+
+    result.seconds[1] = TimeKernel(iterations, [&]
+    {
+        uint64_t size = 0;
+        for (const FieldValue& value : values)
+            size += FieldIO::GetFieldsSize(program, value);
+        sink = sink + size;
+    });
+
+    result.seconds[2] = TimeKernel(iterations, [&]
+    {
+        IoUtils::MemoryWriter out;
+        out.ReserveCapacity(input.GetSize());
+        for (const FieldValue& value : values)
+            FieldIO::WriteFields(out, program, value);
+        sink = sink + out.GetSize();
+    });
+
+    result.seconds[3] = TimeKernel(iterations, [&]
+    {
+        IoUtils::MemoryWriter out;
+        out.ReserveCapacity(input.GetSize());
+        FieldIO::FieldLayout layout;
+        for (const FieldValue& value : values)
+            FieldIO::WriteFields(out, program, value, &layout);
+        sink = sink + out.GetSize() + layout.hashOffsets.size();
+    });
+
+    result.seconds[4] = TimeKernel(iterations, [&]
+    {
+        std::ostringstream out;
+        {
+            JsonWriter writer(out);
+            writer.BeginArray();
+            for (const FieldValue& value : values)
+                FieldIO::WriteJson(writer, value);
+            writer.EndArray();
+        }
+        sink = sink + out.tellp();
+    });
+
+    std::vector<ordered_json> documents;
+    for (const FieldValue& value : values)
+        documents.push_back(FieldIO::ToJson(value));
+
+    Arena jsonArena(1024 * 1024);
+    std::vector<FieldValue> loaded(numRecords);
+    result.seconds[5] = TimeKernel(iterations, [&]
+    {
+        jsonArena.Reset();
+        for (uint32_t r = 0; r < numRecords; r++)
+            FieldIO::FromJson(program, documents[r], jsonArena, loaded[r]);
+    });
+
+    // The records have to come back the same through ToJson and FromJson, or the timings mean nothing
+    IoUtils::MemoryWriter check;
+    for (const FieldValue& value : loaded)
+        FieldIO::WriteFields(check, program, value);
+    if (check.GetSize() != input.GetSize() || memcmp(check.GetData(), input.GetData(), input.GetSize()) != 0)
+        throw std::runtime_error(bench.name + " doesn't convert back to the same binary");
+
+    return result;
+}
+
+static std::vector<BenchCase> GetCases()
+{
+    std::vector<BenchCase> cases;
+    for (const KindCase& kind : s_KindCases)
+    {
+        BenchCase& bench = cases.emplace_back();
+        bench.name = kind.name;
+        for (uint32_t i = 0; i < kind.copies; i++)
+            bench.fieldNames.push_back("Field" + std::to_string(i));
+        for (const std::string& name : bench.fieldNames)
+        {
+            FieldDef field = kind.field;
+            field.name = name;
+            bench.fieldDefs.push_back(field);
+        }
+        bench.fields.data = bench.fieldDefs.data();
+        bench.fields.count = bench.fieldDefs.size();
+    }
+
+    for (const TypeCase& type : s_TypeCases)
+    {
+        const MetadataFileDef* def = g_Registry.GetFileDef(type.schema);
+        const MetadataTypeDef* typeDef = def ? def->FindType(std::string_view(type.type)) : nullptr;
+        if (!typeDef)
+            throw std::runtime_error(std::string("No type ") + type.type + " in " + type.schema);
+
+        BenchCase& bench = cases.emplace_back();
+        bench.name = type.type;
+        bench.fields = typeDef->fields;
+    }
+    return cases;
+}
+
+int main(int argc, char** argv)
+{
+    g_Registry.RegisterAll();
+
+    uint32_t iterations = 5;
+    uint32_t numRecords = 4096;
+    std::string filter;
+    std::string outPath;
+
+    const char* usage = "Usage: ivam-fieldbench [-n iterations] [-r records] [-f filter] [-o results.json]";
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if ((arg == "-n" || arg == "--iterations") && i + 1 < argc)
+        {
+            if (!AMT::Bench::ParseCount(argv[++i], iterations))
+                return AMT::Bench::ReportBadValue(arg, argv[i], usage);
+            iterations = std::max<uint32_t>(1, iterations);
+        }
+        else if ((arg == "-r" || arg == "--records") && i + 1 < argc)
+        {
+            if (!AMT::Bench::ParseCount(argv[++i], numRecords))
+                return AMT::Bench::ReportBadValue(arg, argv[i], usage);
+            numRecords = std::max<uint32_t>(1, numRecords);
+        }
+        else if ((arg == "-f" || arg == "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if ((arg == "-o" || arg == "--out") && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            std::cout << usage << std::endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        // Most hash fields resolve to a name, like they do in retail files
+        std::vector<std::string> names;
+        for (uint32_t i = 0; i < 4096; i++)
+        {
+            names.push_back("BENCH_NAME_" + std::to_string(i));
+            HashManager::Instance()->AddHash(names.back());
+        }
+        CorpusGenerator generator(names);
+        generator.Seed(1);
+
+        std::vector<CaseResult> results;
+        for (const BenchCase& bench : GetCases())
+        {
+            if (bench.name.find(filter) != std::string::npos)
+                results.push_back(RunCase(bench, generator, numRecords, iterations));
+        }
+
+        // ns per field for each kernel
+        std::cout << std::left << std::setw(28) << "case" << std::right << std::setw(10) << "B/record";
+        for (const char* kernel : s_Kernels)
+            std::cout << std::setw(14) << kernel;
+        std::cout << std::endl;
+
+        AMT::ordered_json report;
+        report["iterations"] = iterations;
+        report["records"] = numRecords;
+        report["cases"] = AMT::ordered_json::array();
+        for (const CaseResult& result : results)
+        {
+            double numFields = static_cast<double>(result.records) * result.fieldsPerRecord;
+
+            std::cout << std::left << std::setw(28) << result.name << std::right << std::setw(10)
+                      << std::fixed << std::setprecision(1) << static_cast<double>(result.bytes) / result.records;
+
+            AMT::ordered_json entry;
+            entry["name"] = result.name;
+            entry["fields_per_record"] = result.fieldsPerRecord;
+            entry["bytes"] = result.bytes;
+            for (size_t k = 0; k < NumKernels; k++)
+            {
+                double seconds = result.seconds[k];
+                double nsPerField = seconds * 1e9 / numFields;
+                std::cout << std::setw(14) << std::setprecision(2) << nsPerField;
+
+                entry["kernels"][s_Kernels[k]] = {
+                    {"seconds", seconds},
+                    {"ns_per_field", nsPerField},
+                    {"mb_per_s", seconds > 0 ? result.bytes / seconds / (1024.0 * 1024.0) : 0.0}
+                };
+            }
+            std::cout << std::endl;
+            report["cases"].push_back(std::move(entry));
+        }
+
+        if (!outPath.empty())
+        {
+            std::ofstream out(outPath);
+            if (!out)
+                throw std::runtime_error("Can't write " + outPath);
+            out << report.dump(4) << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
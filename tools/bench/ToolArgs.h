@@ -0,0 +1,44 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+namespace AMT
+{
+    namespace Bench
+    {
+        // Numeric options of the tools. The whole argument has to be the number, anything
+        // else (a sign, trailing text, a value that doesn't fit) is rejected.
+
+        inline bool ParseCount(const char *text, uint32_t &count)
+        {
+            const char *end = text + strlen(text);
+            auto [ptr, ec] = std::from_chars(text, end, count);
+            return ec == std::errc() && ptr == end && ptr != text;
+        }
+
+        // A weight is a finite number that isn't negative
+        inline bool ParseWeight(const char *text, double &weight)
+        {
+            const char *end = text + strlen(text);
+            double value;
+            auto [ptr, ec] = std::from_chars(text, end, value);
+            if (ec != std::errc() || ptr != end || ptr == text || !(value >= 0.0 && value <= 1e300))
+                return false;
+            weight = value;
+            return true;
+        }
+
+        // Prints what is wrong with an option's value and the usage line, returns the exit code
+        inline int ReportBadValue(const std::string &option, const char *value, const char *usage)
+        {
+            std::cout << "Error: " << option << " needs a number, not " << value << std::endl;
+            std::cout << usage << std::endl;
+            return 1;
+        }
+    } // namespace Bench
+} // namespace AMT
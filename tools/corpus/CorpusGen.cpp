@@ -0,0 +1,246 @@
+#include "pch.h"
+#include "CorpusGenerator.h"
+#include "bench/ToolArgs.h"
+#include "common/MappedFile.h"
+#include "common/MetadataRegistry.h"
+
+// ivam-corpus [options]
+//
+// Writes random but valid metadata files named like the ones ivam converts, built
+// from the schemas in MetadataRegistry. At scale 1 the object counts are roughly
+// those of the retail files.
+//
+//   -s, --scale N        multiplies every object count (default 1)
+//   -c, --count N        objects in each metadata file and voices in each speech file
+//   --mix Type=W,...     relative weights of object types, types left out aren't written.
+//                        Only used for the files whose schema has one of the types.
+//   --seed N             random seed (default 1)
+//   --hashes FILE        names to draw hashes from (default Hashes.txt if present)
+//   -o, --out DIR        output directory (default current)
+//
+// Without a name list the names are made up and written to Hashes.txt next to the files.
+
+using AMT::CorpusGenerator;
+using AMT::IoUtils::MemoryWriter;
+
+struct CorpusFile
+{
+    const char* name;
+    const char* schema; // "speech" for SpeechMetadataMgr files
+    uint32_t count;     // objects, or voices for speech
+};
+
+static const CorpusFile s_CorpusFiles[] = {
+    {"CATEGORIES.DAT15", "categories", 300},
+    {"EP1_CATEGORIES.DAT15", "categories", 50},
+    {"EFFECTS.DAT11", "effects", 200},
+    {"CURVES.DAT12", "curves", 400},
+    {"SOUNDS.DAT15", "sounds", 20000},
+    {"EP1_SOUNDS.DAT15", "sounds", 3000},
+    {"GAME.DAT16", "game", 8000},
+    {"EP2_GAME.DAT16", "game", 1000},
+    {"SPEECH.DAT", "speech", 2000},
+    {"EP1_SPEECH.DAT", "speech", 100},
+};
+
+static AMT::MetadataRegistry g_Registry;
+
+// About 4096 names spread over the whole list, so the corpus hashes like retail files
+static std::vector<std::string> SampleNames(const std::string& path)
+{
+    std::vector<std::string> lines;
+    AMT::MappedFile input;
+    if (!input.Open(path))
+        return lines;
+
+    const char* text = reinterpret_cast<const char*>(input.GetData());
+    size_t size = input.GetSize();
+    for (size_t pos = 0; pos < size;)
+    {
+        const char* end = static_cast<const char*>(memchr(text + pos, '\n', size - pos));
+        size_t next = end ? end - text + 1 : size;
+        std::string line(text + pos, text + next - (end ? 1 : 0));
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty())
+            lines.push_back(std::move(line));
+        pos = next;
+    }
+
+    const size_t MaxNames = 4096;
+    if (lines.size() <= MaxNames)
+        return lines;
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < MaxNames; i++)
+        names.push_back(std::move(lines[i * lines.size() / MaxNames]));
+    return names;
+}
+
+struct TypeWeight
+{
+    std::string type;
+    double weight;
+};
+
+// "Type=weight,..." with the weight defaulting to 1. Returns false at the first weight
+// that isn't a number or is negative, with badWeight set to it.
+static bool ParseMix(const std::string& mix, std::vector<TypeWeight>& out, std::string& badWeight)
+{
+    for (size_t pos = 0; pos < mix.size();)
+    {
+        size_t end = mix.find(',', pos);
+        if (end == std::string::npos)
+            end = mix.size();
+
+        std::string item = mix.substr(pos, end - pos);
+        size_t equals = item.find('=');
+        TypeWeight entry{item.substr(0, equals), 1.0};
+        if (equals != std::string::npos)
+        {
+            badWeight = item.substr(equals + 1);
+            if (!AMT::Bench::ParseWeight(badWeight.c_str(), entry.weight))
+                return false;
+        }
+        out.push_back(std::move(entry));
+        pos = end + 1;
+    }
+    return true;
+}
+
+// One weight per type of def, uniform if the mix names none of them
+static std::vector<double> GetTypeWeights(const AMT::MetadataFileDef& def, const std::vector<TypeWeight>& mix)
+{
+    std::vector<double> weights(def.types.size(), 0.0);
+    bool named = false;
+
+    for (const TypeWeight& entry : mix)
+    {
+        if (const AMT::MetadataTypeDef* type = def.FindType(std::string_view(entry.type)))
+        {
+            weights[type - def.types.data()] = entry.weight;
+            named = true;
+        }
+    }
+
+    if (!named)
+        std::fill(weights.begin(), weights.end(), 1.0);
+    return weights;
+}
+
+static void WriteFile(const std::filesystem::path& path, const MemoryWriter& data)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        throw std::runtime_error("Can't write " + path.string());
+    data.WriteTo(out);
+}
+
+int main(int argc, char** argv)
+{
+    g_Registry.RegisterAll();
+
+    uint32_t scale = 1;
+    uint32_t count = 0;
+    uint32_t seed = 1;
+    std::vector<TypeWeight> mix;
+    std::string hashesPath = "Hashes.txt";
+    std::filesystem::path outDir = ".";
+
+    const char* usage = "Usage: ivam-corpus [-s scale] [-c count] [--mix Type=weight,...] [--seed n] [--hashes file] [-o dir]";
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if ((arg == "-s" || arg == "--scale") && i + 1 < argc)
+        {
+            if (!AMT::Bench::ParseCount(argv[++i], scale))
+                return AMT::Bench::ReportBadValue(arg, argv[i], usage);
+        }
+        else if ((arg == "-c" || arg == "--count") && i + 1 < argc)
+        {
+            if (!AMT::Bench::ParseCount(argv[++i], count))
+                return AMT::Bench::ReportBadValue(arg, argv[i], usage);
+        }
+        else if (arg == "--mix" && i + 1 < argc)
+        {
+            std::string badWeight;
+            if (!ParseMix(argv[++i], mix, badWeight))
+            {
+                std::cout << "Error: --mix weights must be numbers that aren't negative, not " << badWeight << std::endl;
+                std::cout << usage << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            if (!AMT::Bench::ParseCount(argv[++i], seed))
+                return AMT::Bench::ReportBadValue(arg, argv[i], usage);
+        }
+        else if (arg == "--hashes" && i + 1 < argc)
+            hashesPath = argv[++i];
+        else if ((arg == "-o" || arg == "--out") && i + 1 < argc)
+            outDir = argv[++i];
+        else
+        {
+            std::cout << usage << std::endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        std::filesystem::create_directories(outDir);
+
+        std::vector<std::string> names = SampleNames(hashesPath);
+        bool madeUpNames = names.empty();
+        if (madeUpNames)
+        {
+            for (uint32_t i = 0; i < 4096; i++)
+                names.push_back("CORPUS_NAME_" + std::to_string(i));
+        }
+
+        CorpusGenerator generator(names);
+        for (uint32_t i = 0; i < std::size(s_CorpusFiles); i++)
+        {
+            const CorpusFile& file = s_CorpusFiles[i];
+            uint32_t objects = count ? count : file.count * scale;
+
+            // Each file draws from its own sequence
+            generator.Seed(seed * 7919 + i);
+
+            MemoryWriter data;
+            if (strcmp(file.schema, "speech") == 0)
+            {
+                generator.WriteSpeechFile(objects, data);
+            }
+            else
+            {
+                const AMT::MetadataFileDef* def = g_Registry.GetFileDef(file.schema);
+                generator.WriteMetadataFile(*def, GetTypeWeights(*def, mix), objects, data);
+            }
+
+            WriteFile(outDir / file.name, data);
+            std::cout << file.name << ": " << objects << (strcmp(file.schema, "speech") == 0 ? " voices, " : " objects, ")
+                      << data.GetSize() << " bytes" << std::endl;
+        }
+
+        // The made up names are only known to ivam through a list, archive and bank
+        // names are in the files
+        if (madeUpNames)
+        {
+            std::ofstream out(outDir / "Hashes.txt");
+            for (const std::string& name : names)
+                out << name << '\n';
+            for (uint32_t i = 0; i < generator.GetNumVoiceNames(); i++)
+                out << CorpusGenerator::GetVoiceName(i) << '\n';
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
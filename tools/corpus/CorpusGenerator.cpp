@@ -0,0 +1,306 @@
+#include "pch.h"
+#include "CorpusGenerator.h"
+#include "common/FieldIO.h"
+#include "common/HashManager.h"
+#include <unordered_set>
+
+namespace AMT
+{
+    CorpusGenerator::CorpusGenerator(std::vector<std::string> names) : m_Names(std::move(names))
+    {
+        for (uint32_t i = 0; i < NumArchives; i++)
+        {
+            m_Archives.push_back("sfx/corpus_" + std::to_string(i) + "/bank");
+            m_ArchiveHashes.push_back(HashManager::Instance()->StringToHash(m_Archives.back()));
+        }
+        for (uint32_t i = 0; i < NumBanks; i++)
+            m_Banks.push_back("speech/corpus_bank_" + std::to_string(i));
+    }
+
+    void CorpusGenerator::WriteMetadataFile(const MetadataFileDef& def, const std::vector<double>& typeWeights, uint32_t count, IoUtils::MemoryWriter& out)
+    {
+        std::discrete_distribution<size_t> pickType(typeWeights.begin(), typeWeights.end());
+
+        struct ObjectEntry
+        {
+            std::string name;
+            uint32_t offset;
+            uint32_t size;
+        };
+        std::vector<ObjectEntry> objects;
+        objects.reserve(count);
+        m_HashOffsets.clear();
+        m_ArchiveOffsets.clear();
+        m_UsedArchives.clear();
+
+        IoUtils::WriteData(out, def.suffix);
+        size_t dataSizePos = out.Reserve(4);
+        size_t dataStart = out.GetSize();
+
+        uint32_t nameOffset = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const MetadataTypeDef& type = def.types[pickType(m_Rng)];
+
+            // Names are unique, some share a stem with a hash name like retail ones do
+            std::string name = Random(3) ? m_Names[Random(m_Names.size())].substr(0, 200) : "corpus_object";
+            name += "_" + std::to_string(i);
+
+            IoUtils::WriteData<uint8_t>(out, 0);
+            size_t start = out.GetSize();
+            IoUtils::WriteData(out, static_cast<uint8_t>(type.id));
+            if (def.hasNameOffset)
+                IoUtils::WriteData(out, nameOffset);
+            WriteFields(out, def.headerFields);
+            WriteFields(out, type.fields);
+
+            objects.push_back({std::move(name), static_cast<uint32_t>(start - dataStart), static_cast<uint32_t>(out.GetSize() - start)});
+            nameOffset += static_cast<uint32_t>(objects.back().name.size() + 1);
+        }
+        out.Patch(dataSizePos, static_cast<uint32_t>(out.GetSize() - dataStart));
+
+        // Archives named by the objects
+        std::string names;
+        std::vector<uint32_t> offsets;
+        for (uint32_t index : m_UsedArchives)
+        {
+            offsets.push_back(static_cast<uint32_t>(names.size()));
+            names += m_Archives[index];
+            names += '\0';
+        }
+        std::replace(names.begin(), names.end(), '/', '\\');
+        IoUtils::WriteData(out, static_cast<uint32_t>(4 + offsets.size() * 4 + names.size()));
+        IoUtils::WriteData(out, static_cast<uint32_t>(offsets.size()));
+        out.Write(offsets.data(), offsets.size() * 4);
+        out.Write(names.data(), names.size());
+
+        // Object table
+        IoUtils::WriteData(out, static_cast<uint32_t>(objects.size()));
+        IoUtils::WriteData(out, nameOffset);
+        for (const ObjectEntry& obj : objects)
+        {
+            IoUtils::WriteData(out, static_cast<uint8_t>(obj.name.size()));
+            out.Write(obj.name.data(), obj.name.size());
+            IoUtils::WriteData(out, obj.offset);
+            IoUtils::WriteData(out, obj.size);
+        }
+
+        // Positions of the tracked hashes and of the archive hashes
+        IoUtils::WriteData(out, static_cast<uint32_t>(m_HashOffsets.size()));
+        out.Write(m_HashOffsets.data(), m_HashOffsets.size() * 4);
+        IoUtils::WriteData(out, static_cast<uint32_t>(m_ArchiveOffsets.size()));
+        out.Write(m_ArchiveOffsets.data(), m_ArchiveOffsets.size() * 4);
+    }
+
+    void CorpusGenerator::WriteSpeechFile(uint32_t numVoices, IoUtils::MemoryWriter& out)
+    {
+        constexpr size_t ContextRecordSize = 14;
+
+        // Voices are keyed by hash in JSON, names whose hash is taken are skipped
+        std::unordered_set<uint32_t> voiceHashes;
+
+        // Contexts own consecutive runs of variation data, a fifth of them have none
+        std::vector<uint8_t> variationData;
+        IoUtils::MemoryWriter contexts, voices;
+        uint32_t numContexts = 0;
+        for (uint32_t v = 0; v < numVoices; v++)
+        {
+            uint16_t voiceContexts = static_cast<uint16_t>(Random(10));
+            IoUtils::WriteData(voices, static_cast<uint32_t>(numContexts * ContextRecordSize));
+            uint32_t voiceHash;
+            do
+            {
+                voiceHash = HashManager::Instance()->StringToHash(GetVoiceName(m_NumVoiceNames++));
+            } while (!voiceHashes.insert(voiceHash).second);
+
+            IoUtils::WriteData(voices, voiceHash);
+            IoUtils::WriteData(voices, voiceContexts);
+
+            for (uint16_t c = 0; c < voiceContexts; c++)
+            {
+                uint8_t numVariations = Random(5) ? static_cast<uint8_t>(1 + Random(20)) : 0;
+                int32_t offset = numVariations ? static_cast<int32_t>(variationData.size()) : -1;
+                for (uint8_t i = 0; i < numVariations; i++)
+                    variationData.push_back(static_cast<uint8_t>(m_Rng()));
+
+                IoUtils::WriteData(contexts, Random(NumBanks));
+                IoUtils::WriteData(contexts, offset);
+                IoUtils::WriteData(contexts, RandomHash());
+                IoUtils::WriteData(contexts, static_cast<uint8_t>(m_Rng()));
+                IoUtils::WriteData(contexts, numVariations);
+                numContexts++;
+            }
+        }
+
+        IoUtils::WriteData(out, static_cast<uint32_t>(variationData.size()));
+        out.Write(variationData.data(), variationData.size());
+        IoUtils::WriteData(out, numContexts);
+        out.Write(contexts.GetData(), contexts.GetSize());
+        IoUtils::WriteData(out, numVoices);
+        out.Write(voices.GetData(), voices.GetSize());
+
+        std::string heap;
+        std::vector<uint32_t> offsets;
+        for (const std::string& bank : m_Banks)
+        {
+            offsets.push_back(static_cast<uint32_t>(heap.size()));
+            heap += bank;
+            heap += '\0';
+        }
+        std::replace(heap.begin(), heap.end(), '/', '\\');
+        IoUtils::WriteData(out, static_cast<uint32_t>(offsets.size()));
+        out.Write(offsets.data(), offsets.size() * 4);
+        out.Write(heap.data(), heap.size());
+    }
+
+    // Mostly known names, then unknown values and the 0xFFFFFFFF "no hash" value
+    uint32_t CorpusGenerator::RandomHash()
+    {
+        uint32_t roll = Random(10);
+        if (roll < 6)
+            return HashManager::Instance()->StringToHash(m_Names[Random(m_Names.size())]);
+        if (roll < 9)
+            return m_Rng();
+        return 0xFFFFFFFF;
+    }
+
+    void CorpusGenerator::WriteHash(IoUtils::MemoryWriter& out, bool trackedAsHash, bool trackedAsArchive)
+    {
+        uint32_t hash = 0xFFFFFFFF;
+        if (!trackedAsArchive)
+        {
+            hash = RandomHash();
+        }
+        else if (Random(10) != 0)
+        {
+            // Archive hashes always name an archive of the list
+            uint32_t index = Random(NumArchives);
+            hash = m_ArchiveHashes[index];
+            if (std::find(m_UsedArchives.begin(), m_UsedArchives.end(), index) == m_UsedArchives.end())
+                m_UsedArchives.push_back(index);
+        }
+
+        // Like MetadataFile, "no hash" isn't tracked
+        if (hash != 0xFFFFFFFF)
+        {
+            uint32_t offset = static_cast<uint32_t>(out.GetSize());
+            if (trackedAsHash)
+                m_HashOffsets.push_back(offset);
+            if (trackedAsArchive)
+                m_ArchiveOffsets.push_back(offset);
+        }
+        IoUtils::WriteData(out, hash);
+    }
+
+    void CorpusGenerator::WriteCount(IoUtils::MemoryWriter& out, uint32_t count, FieldKind kind)
+    {
+        switch (kind)
+        {
+            case FieldKind::UInt16:
+            case FieldKind::Int16:
+                IoUtils::WriteData(out, static_cast<uint16_t>(count));
+                break;
+            case FieldKind::UInt32:
+            case FieldKind::Int32:
+                IoUtils::WriteData(out, count);
+                break;
+            default:
+                IoUtils::WriteData(out, static_cast<uint8_t>(count));
+                break;
+        }
+    }
+
+    void CorpusGenerator::WriteFields(IoUtils::MemoryWriter& out, SchemaSpan<FieldDef> fields)
+    {
+        for (const FieldDef& field : fields)
+        {
+            // JSON keeps one value for numbers sharing a name (padding), so they are all 0
+            bool isNumber = field.kind <= FieldKind::Float;
+            if (isNumber && std::count_if(fields.begin(), fields.end(), [&](const FieldDef& f) { return f.name == field.name; }) > 1)
+            {
+                out.Reserve(field.kind == FieldKind::Float ? 4 : FieldIO::CountPrefixSize(field.kind));
+                continue;
+            }
+            WriteField(out, field);
+        }
+    }
+
+    void CorpusGenerator::WriteField(IoUtils::MemoryWriter& out, const FieldDef& field)
+    {
+        switch (field.kind)
+        {
+            case FieldKind::UInt8:  IoUtils::WriteData(out, static_cast<uint8_t>(m_Rng())); break;
+            case FieldKind::Int8:   IoUtils::WriteData(out, static_cast<int8_t>(m_Rng())); break;
+            case FieldKind::UInt16: IoUtils::WriteData(out, static_cast<uint16_t>(m_Rng())); break;
+            case FieldKind::Int16:  IoUtils::WriteData(out, static_cast<int16_t>(m_Rng())); break;
+            case FieldKind::UInt32: IoUtils::WriteData(out, static_cast<uint32_t>(m_Rng())); break;
+            case FieldKind::Int32:  IoUtils::WriteData(out, static_cast<int32_t>(m_Rng())); break;
+            case FieldKind::Float:
+                // At most 6 significant digits, which is what the JSON form keeps
+                IoUtils::WriteData(out, static_cast<float>(static_cast<int32_t>(Random(1999999)) - 999999) / 1000.0f);
+                break;
+            case FieldKind::Hash:
+                WriteHash(out, field.trackedAsHash, field.trackedAsArchive);
+                break;
+            case FieldKind::String:
+            {
+                uint32_t length = Random(20);
+                WriteCount(out, length, field.countKind);
+                for (uint32_t i = 0; i < length; i++)
+                    IoUtils::WriteData(out, static_cast<char>('a' + Random(26)));
+                break;
+            }
+            case FieldKind::Array:
+            {
+                uint32_t count = Random(8);
+                WriteCount(out, count, field.countKind);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    if (field.arrayElementsAreTrackedHashes)
+                        WriteHash(out, true, field.children[0].trackedAsArchive);
+                    else
+                        WriteFields(out, field.children);
+                }
+                break;
+            }
+            case FieldKind::FixedArray:
+                for (int i = 0; i < field.fixedCount; i++)
+                    WriteFields(out, field.children);
+                break;
+            case FieldKind::Struct:
+                WriteFields(out, field.children);
+                break;
+            case FieldKind::OptionalBitfield:
+            {
+                // None, all or a random subset of the fields present
+                uint32_t mask = field.children.size() >= 32 ? 0xFFFFFFFF : (1u << field.children.size()) - 1;
+                uint32_t roll = Random(4);
+                uint32_t bits = (roll == 0 ? 0 : roll == 1 ? mask : static_cast<uint32_t>(m_Rng())) & mask;
+                IoUtils::WriteData(out, bits);
+                for (size_t i = 0; i < field.children.size(); i++)
+                {
+                    if (bits & (1u << i))
+                        WriteField(out, field.children[i]);
+                }
+                break;
+            }
+            case FieldKind::Enum:
+            {
+                // Some values have no name and are written as numbers
+                int64_t value = Random(8) == 0 || field.enumValues.empty() ? Random(200) : field.enumValues[Random(field.enumValues.size())].value;
+                WriteCount(out, static_cast<uint32_t>(value), field.enumBaseKind);
+                break;
+            }
+            case FieldKind::Placeholder:
+            {
+                // Without a size the blob runs to the end of the object
+                uint32_t size = field.placeholderSize > 0 ? field.placeholderSize : Random(600);
+                for (uint32_t i = 0; i < size; i++)
+                    IoUtils::WriteData(out, static_cast<uint8_t>(m_Rng()));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+} // namespace AMT
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common/FieldDef.h"
+#include "common/IoUtils.h"
+#include "common/MetadataTypeDef.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace AMT
+{
+    // Random but valid binary metadata. Converting what it writes to JSON and back
+    // gives the same bytes.
+    class CorpusGenerator
+    {
+        std::mt19937 m_Rng;
+        std::vector<std::string> m_Names;    // values of hash fields and stems of object names
+        std::vector<std::string> m_Archives;
+        std::vector<uint32_t> m_ArchiveHashes;
+        std::vector<std::string> m_Banks;    // speech string table
+        uint32_t m_NumVoiceNames = 0;
+
+        // Tables at the end of a metadata file, gathered while its objects are written
+        std::vector<uint32_t> m_HashOffsets;
+        std::vector<uint32_t> m_ArchiveOffsets;
+        std::vector<uint32_t> m_UsedArchives; // indexes into m_Archives, in order of first use
+
+        static constexpr uint32_t NumArchives = 30;
+        static constexpr uint32_t NumBanks = 20;
+
+    public:
+        // Hash fields are drawn from names (which must not be empty)
+        explicit CorpusGenerator(std::vector<std::string> names);
+
+        void Seed(uint32_t seed) { m_Rng.seed(seed); }
+
+        // Voices written so far are named GetVoiceName(0) to GetVoiceName(GetNumVoiceNames() - 1)
+        static std::string GetVoiceName(uint32_t index) { return "CORPUS_VOICE_" + std::to_string(index); }
+        uint32_t GetNumVoiceNames() const { return m_NumVoiceNames; }
+
+        // typeWeights has one entry per type of def, objects pick their type by weight
+        void WriteMetadataFile(const MetadataFileDef& def, const std::vector<double>& typeWeights, uint32_t count, IoUtils::MemoryWriter& out);
+
+        void WriteSpeechFile(uint32_t numVoices, IoUtils::MemoryWriter& out);
+
+        // Values for a list of fields on their own, e.g. the fields of one object
+        void WriteFields(IoUtils::MemoryWriter& out, SchemaSpan<FieldDef> fields);
+
+    private:
+        uint32_t Random(size_t n) { return static_cast<uint32_t>(m_Rng() % n); }
+
+        uint32_t RandomHash();
+        void WriteHash(IoUtils::MemoryWriter& out, bool trackedAsHash, bool trackedAsArchive);
+        static void WriteCount(IoUtils::MemoryWriter& out, uint32_t count, FieldKind kind);
+        void WriteField(IoUtils::MemoryWriter& out, const FieldDef& field);
+    };
+} // namespace AMT